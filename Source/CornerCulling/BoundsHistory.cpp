@@ -0,0 +1,50 @@
+#include "BoundsHistory.h"
+
+void BoundsHistory::Reset(int NewNumSnapshots, int NewNumCharacters)
+{
+    NumSnapshots = NewNumSnapshots;
+    NumCharacters = NewNumCharacters;
+    Entries.assign(NumSnapshots * NumCharacters, CharacterBounds());
+    EntryTicks.assign(NumSnapshots * NumCharacters, -1);
+    LatestTicks.assign(NumCharacters, -1);
+}
+
+CharacterBounds& BoundsHistory::Record(int i, int Tick)
+{
+    int Index = GetIndex(i, Tick);
+    EntryTicks[Index] = Tick;
+    LatestTicks[i] = Tick;
+    return Entries[Index];
+}
+
+const CharacterBounds& BoundsHistory::Get(int i, int Tick) const
+{
+    int Latest = LatestTicks[i];
+    // Characters that have not moved since Tick are read directly.
+    if (Tick >= Latest)
+    {
+        return Entries[GetIndex(i, Latest)];
+    }
+    // Entries from the last Capacity() ticks before the latest one
+    // have not been overwritten, so walk back to the latest one at or
+    // before Tick.
+    int Oldest = std::max(0, Latest - NumSnapshots + 1);
+    for (int t = Tick; t >= Oldest; t--)
+    {
+        int Index = GetIndex(i, t);
+        if (EntryTicks[Index] == t)
+        {
+            return Entries[Index];
+        }
+    }
+    // No entry precedes Tick, so use the oldest one.
+    for (int t = Oldest; t < Latest; t++)
+    {
+        int Index = GetIndex(i, t);
+        if (EntryTicks[Index] == t)
+        {
+            return Entries[Index];
+        }
+    }
+    return Entries[GetIndex(i, Latest)];
+}
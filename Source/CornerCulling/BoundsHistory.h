@@ -0,0 +1,61 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GeometricPrimitives.h"
+#include <vector>
+
+// Ring buffer of the bounds of every character at each recent tick.
+// Snapshots are allocated once and overwritten in place, so recording a tick
+// does not allocate, and readers reference snapshots instead of copying them.
+// Each character is recorded only on ticks that it moved, and keeps its
+// latest bounds until it moves again.
+class BoundsHistory
+{
+    // Bounds of every character in each snapshot, one snapshot after another.
+    std::vector<CharacterBounds> Entries;
+    // Tick that each entry was recorded at, or -1 if it is empty.
+    std::vector<int> EntryTicks;
+    // Latest tick that each character was recorded at, or -1 if never.
+    std::vector<int> LatestTicks;
+    int NumSnapshots = 0;
+    int NumCharacters = 0;
+
+    int GetIndex(int i, int Tick) const
+    {
+        return (Tick % NumSnapshots) * NumCharacters + i;
+    }
+
+public:
+    // Allocates NumSnapshots snapshots of NumCharacters characters
+    // and clears the history.
+    void Reset(int NewNumSnapshots, int NewNumCharacters);
+    int Capacity() const { return NumSnapshots; }
+    int GetNumCharacters() const { return NumCharacters; }
+    // Gets the entry of character i at Tick for the caller to overwrite,
+    // in place of its entry from Capacity() ticks earlier.
+    CharacterBounds& Record(int i, int Tick);
+    // Checks if character i has ever been recorded.
+    bool IsRecorded(int i) const { return LatestTicks[i] >= 0; }
+    // Gets the bounds of character i at the latest tick at or before Tick
+    // that it was recorded at, or at its oldest entry if Tick has left
+    // the buffer. Character i must have been recorded.
+    const CharacterBounds& Get(int i, int Tick) const;
+};
+
+// The bounds of each character at its own tick of a history.
+// Indexes like a vector of bounds, but only points into the snapshots,
+// which stay valid until the history records over them.
+class BoundsView
+{
+    std::vector<const CharacterBounds*> Entries;
+
+public:
+    void Resize(int NumCharacters) { Entries.resize(NumCharacters); }
+    // Points character i at its bounds at Tick.
+    void Set(const BoundsHistory& History, int i, int Tick)
+    {
+        Entries[i] = &History.Get(i, Tick);
+    }
+    const CharacterBounds& operator[](int i) const { return *Entries[i]; }
+    size_t size() const { return Entries.size(); }
+};
@@ -0,0 +1,226 @@
+#include "CellPortalGraph.h"
+
+// Signed distance from a point to the plane of face i of a cuboid.
+// Positive outside of the cuboid.
+static inline float FaceDistance(const Cuboid& C, int i, const FVector& Point)
+{
+    return C.Faces[i].Normal | (Point - C.GetVertex(i, 0));
+}
+
+// Checks if an axis separates two sets of points.
+static inline bool Separates(
+    const FVector& Axis,
+    const FVector* A,
+    int NumA,
+    const FVector* B,
+    int NumB)
+{
+    float MinA = FLT_MAX, MaxA = -FLT_MAX, MinB = FLT_MAX, MaxB = -FLT_MAX;
+    for (int i = 0; i < NumA; i++)
+    {
+        float D = Axis | A[i];
+        MinA = std::min(MinA, D);
+        MaxA = std::max(MaxA, D);
+    }
+    for (int i = 0; i < NumB; i++)
+    {
+        float D = Axis | B[i];
+        MinB = std::min(MinB, D);
+        MaxB = std::max(MaxB, D);
+    }
+    return MaxA < MinB || MaxB < MinA;
+}
+
+// Checks if the convex hulls of two sets of points are disjoint with the
+// separating axis theorem. Tests every edge-edge cross product, including
+// edges between any two points of a set, so no hull has to be built.
+// Returning false only means that no separating axis was found.
+static bool AreDisjoint(const FVector* A, int NumA, const FVector* B, int NumB)
+{
+    std::vector<FVector> EdgesA, EdgesB;
+    for (int i = 0; i < NumA; i++)
+    {
+        for (int j = i + 1; j < NumA; j++)
+        {
+            EdgesA.emplace_back(A[j] - A[i]);
+        }
+    }
+    for (int i = 0; i < NumB; i++)
+    {
+        for (int j = i + 1; j < NumB; j++)
+        {
+            EdgesB.emplace_back(B[j] - B[i]);
+        }
+    }
+    auto TryAxis = [&](const FVector& Axis)
+    {
+        return Axis.SizeSquared() > 1e-6f && Separates(Axis, A, NumA, B, NumB);
+    };
+    for (const std::vector<FVector>* Edges : { &EdgesA, &EdgesB })
+    {
+        for (int i = 0; i < Edges->size(); i++)
+        {
+            for (int j = i + 1; j < Edges->size(); j++)
+            {
+                if (TryAxis((*Edges)[i] ^ (*Edges)[j]))
+                {
+                    return true;
+                }
+            }
+        }
+    }
+    for (const FVector& EdgeA : EdgesA)
+    {
+        for (const FVector& EdgeB : EdgesB)
+        {
+            if (TryAxis(EdgeA ^ EdgeB))
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+int CellPortalGraph::Build(
+    const std::vector<Cuboid>& CellVolumes,
+    const std::vector<Portal>& CellPortalList)
+{
+    Cells = CellVolumes;
+    Portals = CellPortalList;
+    CellPortals.assign(Cells.size(), std::vector<int>());
+    for (int p = 0; p < Portals.size(); p++)
+    {
+        CellPortals[Portals[p].Cells[0]].emplace_back(p);
+        CellPortals[Portals[p].Cells[1]].emplace_back(p);
+    }
+    WordsPerRow = (Cells.size() + 63) / 64;
+    Visible.assign(Cells.size() * WordsPerRow, 0);
+    std::vector<int> Path;
+    std::vector<bool> InPath(Cells.size(), false);
+    int Truncated = 0;
+    for (int Source = 0; Source < Cells.size(); Source++)
+    {
+        MarkVisible(Source, Source);
+        InPath[Source] = true;
+        int StepsLeft = MAX_PORTAL_STEPS;
+        Propagate(Source, Source, Path, InPath, StepsLeft);
+        InPath[Source] = false;
+        if (StepsLeft <= 0)
+        {
+            Truncated++;
+        }
+    }
+    return Truncated;
+}
+
+void CellPortalGraph::Propagate(
+    int Source,
+    int C,
+    std::vector<int>& Path,
+    std::vector<bool>& InPath,
+    int& StepsLeft)
+{
+    if (Path.size() >= MAX_PORTAL_DEPTH)
+    {
+        // Give up on proving anything beyond this depth.
+        MarkAllVisible(Source);
+        return;
+    }
+    for (int p : CellPortals[C])
+    {
+        if (StepsLeft <= 0)
+        {
+            return;
+        }
+        const Portal& P = Portals[p];
+        int Next = (P.Cells[0] == C) ? P.Cells[1] : P.Cells[0];
+        if (InPath[Next])
+        {
+            continue;
+        }
+        Path.emplace_back(p);
+        if (MayBeStabbed(Path))
+        {
+            MarkVisible(Source, Next);
+            if (--StepsLeft == 0)
+            {
+                // Give up on proving anything more from this source.
+                MarkAllVisible(Source);
+            }
+            else
+            {
+                InPath[Next] = true;
+                Propagate(Source, Next, Path, InPath, StepsLeft);
+                InPath[Next] = false;
+            }
+        }
+        Path.pop_back();
+    }
+}
+
+// A line through the first and last portals lies in the convex hull of the
+// two, so it can only pass through an intermediate portal that intersects
+// that hull. This is a necessary condition for a stabbing line,
+// so pruning with it never hides a visible cell.
+bool CellPortalGraph::MayBeStabbed(const std::vector<int>& Path) const
+{
+    if (Path.size() < 3)
+    {
+        return true;
+    }
+    FVector Ends[8];
+    for (int i = 0; i < 4; i++)
+    {
+        Ends[i] = Portals[Path.front()].Corners[i];
+        Ends[i + 4] = Portals[Path.back()].Corners[i];
+    }
+    for (int i = 1; i < Path.size() - 1; i++)
+    {
+        if (AreDisjoint(Portals[Path[i]].Corners, 4, Ends, 8))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+int CellPortalGraph::FindCell(const FVector& Point, float Margin) const
+{
+    for (int c = 0; c < Cells.size(); c++)
+    {
+        bool Inside = true;
+        for (int i = 0; i < CUBOID_F && Inside; i++)
+        {
+            Inside = FaceDistance(Cells[c], i, Point) <= -Margin;
+        }
+        if (Inside)
+        {
+            return c;
+        }
+    }
+    return -1;
+}
+
+int CellPortalGraph::FindCell(const CharacterBounds& Bounds) const
+{
+    int C = FindCell(Bounds.Center, 0);
+    if (C < 0)
+    {
+        return -1;
+    }
+    for (const FVector (*Vertices)[4] : { &Bounds.TopVertices, &Bounds.BottomVertices })
+    {
+        for (const FVector& V : *Vertices)
+        {
+            for (int i = 0; i < CUBOID_F; i++)
+            {
+                if (FaceDistance(Cells[C], i, V) > 0)
+                {
+                    return -1;
+                }
+            }
+        }
+    }
+    return C;
+}
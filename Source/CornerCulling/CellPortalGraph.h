@@ -0,0 +1,84 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GeometricPrimitives.h"
+#include <cstdint>
+#include <vector>
+
+// Maximum number of portals that a line of sight may pass through.
+constexpr int MAX_PORTAL_DEPTH = 16;
+// Maximum number of portal sequences explored from each cell. Enumerating
+// sequences is exponential in the number of portals, so beyond this every
+// cell is assumed visible from the source cell.
+constexpr int MAX_PORTAL_STEPS = 1 << 14;
+
+// Rectangular opening between two cells.
+struct Portal
+{
+    FVector Corners[4];
+    int Cells[2];
+};
+
+// Cell-and-portal graph of an indoor map, with a precomputed
+// cell-to-cell potentially visible set.
+// Lines of sight may only leave a cell through one of its portals, so an
+// enemy in cell B can only be seen from cell A if some line passes through
+// a sequence of portals from A to B. Visibility is computed conservatively:
+// a sequence of portals is only ruled out when we can prove that no line
+// passes through all of them.
+class CellPortalGraph
+{
+    // Volumes of the cells.
+    std::vector<Cuboid> Cells;
+    std::vector<Portal> Portals;
+    // Indices of portals leaving each cell.
+    std::vector<std::vector<int>> CellPortals;
+    // Bitset rows of the potentially visible set.
+    // Bit B of row A is set if cell B may be visible from cell A.
+    std::vector<uint64_t> Visible;
+    int WordsPerRow = 0;
+
+    void MarkVisible(int A, int B)
+    {
+        Visible[A * WordsPerRow + B / 64] |= uint64_t(1) << (B % 64);
+        Visible[B * WordsPerRow + A / 64] |= uint64_t(1) << (A % 64);
+    }
+    // Marks every cell as visible from a source cell.
+    void MarkAllVisible(int Source)
+    {
+        for (int Cell = 0; Cell < Cells.size(); Cell++)
+        {
+            MarkVisible(Source, Cell);
+        }
+    }
+    // Extends a sequence of portals from a source cell through cell C,
+    // spending one of StepsLeft for each sequence explored.
+    void Propagate(
+        int Source,
+        int C,
+        std::vector<int>& Path,
+        std::vector<bool>& InPath,
+        int& StepsLeft);
+    // Checks if a line could pass through every portal in the path.
+    bool MayBeStabbed(const std::vector<int>& Path) const;
+
+public:
+    // Builds the graph and computes the potentially visible set.
+    // Returns the number of cells whose exploration ran out of steps.
+    int Build(const std::vector<Cuboid>& CellVolumes, const std::vector<Portal>& CellPortalList);
+    int NumCells() const
+    {
+        return Cells.size();
+    }
+    // Gets the index of the cell that contains a point, with every face of
+    // the cell at least Margin away, or -1 if there is no such cell.
+    int FindCell(const FVector& Point, float Margin) const;
+    // Gets the index of the cell that contains all vertices of a character's
+    // bounding box, or -1 if there is no such cell.
+    int FindCell(const CharacterBounds& Bounds) const;
+    // Checks if any point in cell B may be visible from any point in cell A.
+    bool CanSee(int A, int B) const
+    {
+        return (Visible[A * WordsPerRow + B / 64] >> (B % 64)) & 1;
+    }
+};
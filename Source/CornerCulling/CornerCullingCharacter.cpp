@@ -158,4 +158,30 @@ void ACornerCullingCharacter::Tick(float DeltaTime)
 		FVector Offset = 20 * FVector(0.6f - FMath::FRand(), 0.6f - FMath::FRand(), 0);
 		AddActorWorldOffset(Offset);
 	}
+	PushMovement();
+}
+
+void ACornerCullingCharacter::PushMovement()
+{
+	if (Movements == nullptr)
+	{
+		return;
+	}
+	FVector CameraLocation = FirstPersonCameraComponent->GetComponentLocation();
+	FTransform Transform = GetActorTransform();
+	FVector Velocity = GetVelocity();
+	// Velocity can change without the character moving, such as when it
+	// stops, and the controller sizes peeks from it.
+	if (HasPushedMovement
+		&& CameraLocation.Equals(LastPushedCameraLocation)
+		&& Transform.Equals(LastPushedTransform)
+		&& Velocity.Equals(LastPushedVelocity))
+	{
+		return;
+	}
+	Movements->Enqueue({ CullingId, int32(GFrameCounter), CameraLocation, Transform, Velocity });
+	LastPushedCameraLocation = CameraLocation;
+	LastPushedTransform = Transform;
+	LastPushedVelocity = Velocity;
+	HasPushedMovement = true;
 }
@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
 #include "Camera/CameraComponent.h"
+#include "MovementQueue.h"
 #include "CornerCullingCharacter.generated.h"
 
 class UInputComponent;
@@ -80,6 +81,18 @@ public:
 
 	int TickCount = 0;
 
+	// Queue that this character pushes its movement to, and its index
+	// in the culler. Set by the culling controller.
+	MovementQueue* Movements = nullptr;
+	int CullingId = -1;
+	// Pushes the character's state to Movements if it moved or changed
+	// velocity since the last push.
+	void PushMovement();
+	FVector LastPushedCameraLocation;
+	FTransform LastPushedTransform;
+	FVector LastPushedVelocity;
+	bool HasPushedMovement = false;
+
 	/** Base turn rate, in deg/sec. Other scaling may affect final turn rate. */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category=Camera)
 	float BaseTurnRate;
@@ -0,0 +1,92 @@
+#include "CuboidGrid.h"
+
+void CuboidGrid::Build(
+    const std::vector<Cuboid>& AllCuboids,
+    float NewCellSize,
+    const OccluderFusion* NewFusion)
+{
+    Cuboids = AllCuboids.data();
+    Fusion = NewFusion;
+    Mailbox.assign(AllCuboids.size(), 0);
+    QueryID = 0;
+    std::vector<FBox> Boxes;
+    FBox GridBox(ForceInit);
+    float TotalExtent = 0;
+    for (const Cuboid& C : AllCuboids)
+    {
+        Boxes.emplace_back(FBox(C.Vertices, CUBOID_V));
+        GridBox += Boxes.back();
+        TotalExtent += Boxes.back().GetSize().GetMax();
+    }
+    CellSize = NewCellSize > 0
+        ? NewCellSize
+        : TotalExtent / std::max<int>(1, AllCuboids.size());
+    FVector Size = GridBox.GetSize();
+    // Coarsen cells that would exceed the maximum dimensions.
+    CellSize = std::max(CellSize, Size.GetMax() / MAX_GRID_DIM);
+    CellSize = std::max(CellSize, 1.0f);
+    Origin = GridBox.Min;
+    for (int k = 0; k < 3; k++)
+    {
+        Dims[k] = FMath::Clamp(FMath::CeilToInt(Size[k] / CellSize), 1, MAX_GRID_DIM);
+    }
+    // Count the cuboids of each cell, then fill them in.
+    int NumCells = Dims[0] * Dims[1] * Dims[2];
+    CellStarts.assign(NumCells + 1, 0);
+    for (int Pass = 0; Pass < 2; Pass++)
+    {
+        if (Pass == 1)
+        {
+            for (int i = 0; i < NumCells; i++)
+            {
+                CellStarts[i + 1] += CellStarts[i];
+            }
+            CellCuboids.resize(CellStarts[NumCells]);
+        }
+        std::vector<int> Filled(NumCells, 0);
+        for (int c = 0; c < Boxes.size(); c++)
+        {
+            int Min[3], Max[3];
+            for (int k = 0; k < 3; k++)
+            {
+                Min[k] = FMath::Clamp(FMath::FloorToInt((Boxes[c].Min[k] - Origin[k]) / CellSize), 0, Dims[k] - 1);
+                Max[k] = FMath::Clamp(FMath::FloorToInt((Boxes[c].Max[k] - Origin[k]) / CellSize), 0, Dims[k] - 1);
+            }
+            for (int Z = Min[2]; Z <= Max[2]; Z++)
+            {
+                for (int Y = Min[1]; Y <= Max[1]; Y++)
+                {
+                    for (int X = Min[0]; X <= Max[0]; X++)
+                    {
+                        int Cell = GetCell(X, Y, Z);
+                        if (Pass == 0)
+                        {
+                            CellStarts[Cell + 1]++;
+                        }
+                        else
+                        {
+                            CellCuboids[CellStarts[Cell] + Filled[Cell]++] = c;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+const Cuboid* CuboidGrid::Traverse(
+    const OptSegment& Segment,
+    const std::vector<FVector>& Peeks,
+    const CharacterBounds& Bounds)
+{
+    return Traverse(
+        Segment,
+        [&](const Cuboid* C) -> const Cuboid*
+        {
+            if (Fusion == NULL)
+            {
+                return IsBlocking(Peeks, Bounds, C) ? C : NULL;
+            }
+            return Fusion->FindBlocker(C, Peeks, Bounds);
+        });
+}
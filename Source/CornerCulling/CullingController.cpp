@@ -1,14 +1,27 @@
 #include "CullingController.h"
 #include "OccludingCuboid.h"
 #include "OccludingSphere.h"
+#include "OccluderSimplification.h"
+#include "PVSVolume.h"
+#include "VisibilityCell.h"
+#include "VisibilityPortal.h"
 #include "EngineUtils.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include <algorithm>
 #include <chrono> 
+#include <tuple>
+
+DEFINE_LOG_CATEGORY(LogCulling);
 
 ACullingController::ACullingController()
     : Super()
 {
     PrimaryActorTick.bCanEverTick = true;
     PrimaryActorTick.TickGroup = TG_PrePhysics;
+    std::fill(
+        &LastCulledTicks[0][0],
+        &LastCulledTicks[0][0] + MAX_CHARACTERS * MAX_CHARACTERS,
+        -1);
 }
 
 void ACullingController::BeginPlay()
@@ -17,6 +30,8 @@ void ACullingController::BeginPlay()
     // Add characters.
     for (ACornerCullingCharacter* Player : TActorRange<ACornerCullingCharacter>(GetWorld()))
     {
+        Player->Movements = &Movements;
+        Player->CullingId = Characters.size();
         Characters.emplace_back(Player);
         IsAlive.emplace_back(true);
         Teams.emplace_back(Player->Team);
@@ -26,6 +41,31 @@ void ACullingController::BeginPlay()
     {
         Cuboids.emplace_back(Cuboid(C->Vertices));
     }
+    // Load the PVS, which is keyed by the cuboids as placed in the map.
+    for (APVSVolume* V : TActorRange<APVSVolume>(GetWorld()))
+    {
+        if (PVS.Load(V->GetSettings(), Cuboids))
+        {
+            UE_LOG(LogCulling, Log, TEXT("Loaded PVS of %s."), *V->GetName());
+        }
+        else
+        {
+            UE_LOG(LogCulling, Warning, TEXT("PVS of %s is missing or out of date."), *V->GetName());
+        }
+        break;
+    }
+    if (SimplifyOccluders)
+    {
+        SimplificationStats Stats = SimplifyCuboids(Cuboids);
+        UE_LOG(
+            LogCulling,
+            Log,
+            TEXT("Simplified occluding cuboids: %d before, %d after (%d merged, %d contained)."),
+            Stats.CuboidsBefore,
+            Stats.CuboidsAfter,
+            Stats.Merged,
+            Stats.Contained);
+    }
     if (Cuboids.size() > 0)
     {
         // Build the cuboid BVH.
@@ -34,15 +74,135 @@ void ACullingController::BeginPlay()
         CuboidBVH = std::make_unique
             <FastBVH::BVH<float, Cuboid>>
             (Builder(Cuboids, Converter));
+        if (BenchmarkNodeOrder)
+        {
+            CompareNodeOrders();
+        }
+        if (ReorderBVH)
+        {
+            CuboidBVH->replaceNodes(FastBVH::reorderNodes(CuboidBVH->getNodes()));
+        }
+        // Building the BVH reorders cuboids, so find touching cuboids after.
+        if (FuseOccluders)
+        {
+            Fusion.Build(Cuboids, MERGE_TOLERANCE);
+            UE_LOG(LogCulling, Log, TEXT("Built %d joint cuboids for occluder fusion."), Fusion.NumJoints());
+        }
         CuboidTraverser = std::make_unique
             <Traverser<float, decltype(Intersector)>>
-            (*CuboidBVH.get(), Intersector);
+            (*CuboidBVH.get(), Intersector, FuseOccluders ? &Fusion : NULL);
+        for (const Cuboid& C : Cuboids)
+        {
+            Wall W;
+            WallIndices.emplace_back(W.FromCuboid(&C, PlayableZMin, PlayableZMax) ? Walls.size() : -1);
+            if (WallIndices.back() >= 0)
+            {
+                Walls.emplace_back(W);
+            }
+        }
+        UE_LOG(LogCulling, Log, TEXT("Found %d walls spanning the playable band."), int(Walls.size()));
+        if (Accelerator == EOccluderAccelerator::Grid || BenchmarkAccelerators)
+        {
+            Grid.Build(Cuboids, GridCellSize, FuseOccluders ? &Fusion : NULL);
+        }
+        if (Accelerator == EOccluderAccelerator::CompactBVH || BenchmarkAccelerators)
+        {
+            CompactCuboidBVH = std::make_unique
+                <FastBVH::CompactBVH<CuboidIntersector>>
+                (*CuboidBVH.get(), Intersector, FuseOccluders ? &Fusion : NULL);
+            UE_LOG(
+                LogCulling,
+                Log,
+                TEXT("Compressed BVH nodes from %d to %d bytes."),
+                int(CuboidBVH->getNodes().size() * sizeof(FastBVH::Node<float>)),
+                CompactCuboidBVH->nodeBytes());
+        }
+        if (UseDistanceField)
+        {
+            auto Start = std::chrono::high_resolution_clock::now();
+            SDF.Build(Cuboids, DistanceFieldVoxelSize, SIZE_T(DistanceFieldMemoryMB) << 20);
+            auto Stop = std::chrono::high_resolution_clock::now();
+            UE_LOG(
+                LogCulling,
+                Log,
+                TEXT("Built distance field using %d KB in %d ms."),
+                int(SDF.GetMemoryBytes() >> 10),
+                int(std::chrono::duration_cast<std::chrono::milliseconds>(Stop - Start).count()));
+        }
+        Hints.Reset(HintCellSize);
     }
     // Add occluding spheres.
     for (AOccludingSphere* S : TActorRange<AOccludingSphere>(GetWorld()))
     {
         Spheres.emplace_back(Sphere(S->GetActorLocation(), S->Radius));
     }
+    BuildCellGraph();
+}
+
+void ACullingController::BuildCellGraph()
+{
+    std::vector<Cuboid> CellVolumes;
+    std::vector<Portal> Portals;
+    TMap<AVisibilityCell*, int> CellIndices;
+    for (AVisibilityCell* C : TActorRange<AVisibilityCell>(GetWorld()))
+    {
+        C->Update();
+        CellIndices.Add(C, CellVolumes.size());
+        CellVolumes.emplace_back(C->Volume);
+    }
+    for (AVisibilityPortal* P : TActorRange<AVisibilityPortal>(GetWorld()))
+    {
+        if (!CellIndices.Contains(P->CellA) || !CellIndices.Contains(P->CellB))
+        {
+            UE_LOG(LogCulling, Warning, TEXT("Portal %s does not connect two cells."), *P->GetName());
+            continue;
+        }
+        P->Update();
+        Portal NewPortal;
+        for (int i = 0; i < 4; i++)
+        {
+            NewPortal.Corners[i] = P->Corners[i];
+        }
+        NewPortal.Cells[0] = CellIndices[P->CellA];
+        NewPortal.Cells[1] = CellIndices[P->CellB];
+        Portals.emplace_back(NewPortal);
+    }
+    if (CellVolumes.size() > 0)
+    {
+        auto Start = std::chrono::high_resolution_clock::now();
+        int Truncated = CellGraph.Build(CellVolumes, Portals);
+        auto Stop = std::chrono::high_resolution_clock::now();
+        UE_LOG(
+            LogCulling,
+            Log,
+            TEXT("Built cell-and-portal graph with %d cells and %d portals in %d ms."),
+            int(CellVolumes.size()),
+            int(Portals.size()),
+            int(std::chrono::duration_cast<std::chrono::milliseconds>(Stop - Start).count()));
+        if (Truncated > 0)
+        {
+            UE_LOG(
+                LogCulling,
+                Warning,
+                TEXT("Portal exploration ran out of steps in %d cells, which see every cell."),
+                Truncated);
+        }
+    }
+}
+
+void ACullingController::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    // Wait for any running cull before the state it reads is destroyed.
+    Worker.reset();
+    // Stop characters from pushing to the queue once it is destroyed.
+    for (ACornerCullingCharacter* Player : Characters)
+    {
+        if (IsValid(Player))
+        {
+            Player->Movements = nullptr;
+        }
+    }
+    Super::EndPlay(EndPlayReason);
 }
 
 void ACullingController::Tick(float DeltaTime)
@@ -54,9 +214,23 @@ void ACullingController::Tick(float DeltaTime)
 void ACullingController::BenchmarkCull()
 {
     auto Start = std::chrono::high_resolution_clock::now();
-    Cull();
+    if (UseAsyncCulling)
+    {
+        CullAsync();
+    }
+    else
+    {
+        Cull();
+    }
     auto Stop = std::chrono::high_resolution_clock::now();
-    UpdateVisibility();
+    if (UseAsyncCulling)
+    {
+        RevealEnemies();
+    }
+    else
+    {
+        UpdateVisibility();
+    }
     int Delta = std::chrono::duration_cast<std::chrono::microseconds>(Stop - Start).count();
     TotalTime += Delta;
     RollingTotalTime += Delta;
@@ -77,6 +251,35 @@ void ACullingController::BenchmarkCull()
             Msg = "Rolling max time to cull (microseconds): "
                 + FString::FromInt(RollingMaxTime);
             GEngine->AddOnScreenDebugMessage(3, 2.0f, Color, Msg, true, Scale);
+            // The worker updates the hint counters during asynchronous culls.
+            if (UseOccluderHints && !UseAsyncCulling && Hints.Lookups > 0)
+            {
+                Msg = "Occluder hint hit rate (%): "
+                    + FString::FromInt(100 * Hints.Hits / Hints.Lookups);
+                GEngine->AddOnScreenDebugMessage(8, 2.0f, Color, Msg, true, Scale);
+            }
+            if (UseAsyncCulling)
+            {
+                Msg = "Ticks waiting for the culling worker: "
+                    + FString::FromInt(AsyncStalls);
+                GEngine->AddOnScreenDebugMessage(9, 2.0f, Color, Msg, true, Scale);
+            }
+            if (CullingBudget > 0)
+            {
+                Msg = "Pairs deferred by the culling budget: "
+                    + FString::FromInt(DeferredPairs)
+                    + ", budget overruns: "
+                    + FString::FromInt(BudgetOverruns);
+                GEngine->AddOnScreenDebugMessage(10, 2.0f, Color, Msg, true, Scale);
+            }
+        }
+        AsyncStalls = 0;
+        DeferredPairs = 0;
+        BudgetOverruns = 0;
+        if (!UseAsyncCulling)
+        {
+            Hints.Lookups = 0;
+            Hints.Hits = 0;
         }
         RollingTotalTime = 0;
         RollingMaxTime = 0;
@@ -84,133 +287,753 @@ void ACullingController::BenchmarkCull()
 }
 
 void ACullingController::Cull()
+{
+    if (PrepareCull())
+    {
+        RunCull();
+        DeferredPairs += CullDeferredPairs;
+        BudgetOverruns += CullOverranBudget;
+    }
+}
+
+bool ACullingController::PrepareCull()
 {
     // TODO:
     //   When running multiple servers per CPU, consider staggering
     //   culling periods to avoid lag spikes.
-    if ((TotalTicks % CullingPeriod) == 0)
+    PreviousCullTick = CullTick;
+    CullTick = TotalTicks;
+    UpdateLatencies();
+    // Record bounds on every cull so that each player's bounds can be delayed
+    // by their own latency.
+    UpdateCharacterBounds();
+    bool AnyCulled = false;
+    for (int i = 0; i < Characters.size(); i++)
+    {
+        AnyCulled |= IsAlive[i] && (IsCullingTick(i) || DeferredCounts[i] > 0);
+    }
+    if (!AnyCulled)
+    {
+        return false;
+    }
+    // Peek displacements read each character's movement component.
+    PeekDisplacements.resize(Characters.size());
+    for (int i = 0; i < Characters.size(); i++)
+    {
+        if (IsAlive[i])
+        {
+            PeekDisplacements[i] = GetPeekDisplacements(i);
+        }
+    }
+    return true;
+}
+
+void ACullingController::RunCull()
+{
+    auto Start = std::chrono::high_resolution_clock::now();
+    PopulateBundles();
+    std::vector<Bundle> Due;
+    Due.swap(BundleQueue);
+    bool Budgeted = CullingBudget > 0;
+    if (Budgeted)
+    {
+        SortByPriority(Due);
+    }
+    // Pairs deferred by the last cull were all due, so only mark the pairs
+    // that this cull defers.
+    std::fill(&IsDeferred[0][0], &IsDeferred[0][0] + MAX_CHARACTERS * MAX_CHARACTERS, false);
+    std::fill(DeferredCounts, DeferredCounts + MAX_CHARACTERS, 0);
+    std::vector<Bundle> Visible;
+    int Next = 0;
+    int Elapsed = 0;
+    while (Next < Due.size())
+    {
+        int End = Budgeted ? std::min<int>(Next + BudgetChunkSize, Due.size()) : Due.size();
+        BundleQueue.assign(Due.begin() + Next, Due.begin() + End);
+        // Stages that gather cuboids once per player need each player's
+        // bundles to be contiguous, which sorting by priority breaks.
+        if (Budgeted)
+        {
+            std::stable_sort(
+                BundleQueue.begin(),
+                BundleQueue.end(),
+                [](const Bundle& A, const Bundle& B) { return A.PlayerI < B.PlayerI; });
+        }
+        CullBundles(Next == 0);
+        Visible.insert(Visible.end(), BundleQueue.begin(), BundleQueue.end());
+        for (int k = Next; k < End; k++)
+        {
+            WasVisible[Due[k].PlayerI][Due[k].EnemyI] = false;
+            LastCulledTicks[Due[k].PlayerI][Due[k].EnemyI] = CullTick;
+        }
+        Next = End;
+        auto Now = std::chrono::high_resolution_clock::now();
+        Elapsed = std::chrono::duration_cast<std::chrono::microseconds>(Now - Start).count();
+        if (Budgeted && Elapsed >= CullingBudget)
+        {
+            break;
+        }
+    }
+    for (const Bundle& B : Visible)
+    {
+        WasVisible[B.PlayerI][B.EnemyI] = true;
+    }
+    // Defer the pairs that are left, revealing them according to the policy.
+    for (int k = Next; k < Due.size(); k++)
+    {
+        const Bundle& B = Due[k];
+        IsDeferred[B.PlayerI][B.EnemyI] = true;
+        DeferredCounts[B.PlayerI]++;
+        if (DeferredPairPolicy == EDeferredPairPolicy::FailOpen
+            || WasVisible[B.PlayerI][B.EnemyI])
+        {
+            Visible.emplace_back(B);
+        }
+    }
+    CullDeferredPairs = int(Due.size()) - Next;
+    CullOverranBudget = Budgeted && Elapsed > CullingBudget;
+    BundleQueue = Visible;
+}
+
+void ACullingController::CullBundles(bool RunBenchmarks)
+{
+    CullWithCache();
+    if (UseOccluderHints)
+    {
+        CullWithHints();
+    }
+    CullWithSpheres();
+    if (UseDistanceField && SDF.IsBuilt())
+    {
+        CullWithDistanceField();
+    }
+    if (UseWallSweep && Walls.size() > 0)
+    {
+        CullWithWalls();
+    }
+    if (UseShadowVolumes)
+    {
+        CullWithShadowVolumes();
+    }
+    // Benchmarks print to the screen, which only the game thread may do.
+    bool IsBenchmarkTick =
+        RunBenchmarks && !UseAsyncCulling && (CullTick % RollingWindowLength) == 0;
+    if (BenchmarkAccelerators && IsBenchmarkTick)
+    {
+        CompareAccelerators();
+    }
+    if (BenchmarkBlockingKernels && IsBenchmarkTick)
+    {
+        CompareBlockingKernels();
+    }
+    if (CuboidBackend == ECuboidCullingBackend::Rasterizer)
+    {
+        CullWithRasterizer();
+    }
+    else
     {
-        UpdateCharacterBounds();
-        PopulateBundles();
-        CullWithCache();
-        CullWithSpheres();
         CullWithCuboids();
     }
+    BundleQueue.insert(BundleQueue.end(), VisibleBundles.begin(), VisibleBundles.end());
+    VisibleBundles.clear();
 }
 
-void ACullingController::UpdateCharacterBounds()
+int ACullingController::GetCullTimer(int i, int j) const
 {
-    Bounds.clear();
-    // This block simulates latency for testing. Remove in production.
-    // Note that this simulation differs subtly from the real setting,
-    // as a real server defines the exact location of all players
-    // that are not controlled by the client that it is culling for.
-    // In this simulation, the game displays the current positions of enemies,
-    // but the server calculates LOS with delayed positions.
-    if (CULLING_SIMULATED_LATENCY > 0)
+    // Asynchronous culls read the timers from when they started.
+    return UseAsyncCulling ? AsyncVisibilityTimers[i][j] : VisibilityTimers[i][j];
+}
+
+void ACullingController::SortByPriority(std::vector<Bundle>& Bundles) const
+{
+    // Cull pairs deferred by the last cull first, so that none starve.
+    // Then cull pairs that were visible, as they are near a transition,
+    // pairs that have waited longest since they were last culled, and
+    // nearby pairs. Timers would not order them, as every due timer has
+    // run out.
+    auto Key = [this](const Bundle& B)
+    {
+        return std::make_tuple(
+            !IsDeferred[B.PlayerI][B.EnemyI],
+            !WasVisible[B.PlayerI][B.EnemyI],
+            LastCulledTicks[B.PlayerI][B.EnemyI],
+            FVector::DistSquared(Bounds[B.PlayerI].CameraLocation, Bounds[B.EnemyI].Center));
+    };
+    std::stable_sort(
+        Bundles.begin(),
+        Bundles.end(),
+        [&Key](const Bundle& A, const Bundle& B) { return Key(A) < Key(B); });
+}
+
+void ACullingController::CullAsync()
+{
+    if (!Worker)
+    {
+        Worker = std::make_unique<CullingWorker>([this]()
+        {
+            RunCull();
+            PublishResults();
+        });
+    }
+    if (AsyncCullTick >= 0 && TotalTicks >= AsyncCullTick + AsyncCullingDelay)
     {
-        // Equivalent to
-        if (PastBounds.size() >= 3)
+        if (Worker->IsBusy())
         {
-            PastBounds.pop_front();
+            AsyncStalls++;
+            Worker->Wait();
         }
-        std::vector<CharacterBounds> CurrentBounds;
+        // The back buffer holds the finished results, so bring it to the front.
+        FrontResults = 1 - FrontResults;
+        const VisibilityResults& Front = Results[FrontResults];
+        DeferredPairs += Front.DeferredPairs;
+        BudgetOverruns += Front.OverranBudget;
         for (int i = 0; i < Characters.size(); i++)
         {
-            if (IsAlive[i])
+            for (int j = 0; j < Characters.size(); j++)
             {
-                CurrentBounds.emplace(
-                    CurrentBounds.begin() + i,
-                    CharacterBounds(
-                        Characters[i]
-                        ->GetFirstPersonCameraComponent()
-                        ->GetComponentLocation(),
-                        Characters[i]->GetActorTransform()));
+                if (Front.Visible[i][j])
+                {
+                    VisibilityTimers[i][j] = GetVisibilityTimerMax(i);
+                }
             }
         }
-        PastBounds.emplace_back(CurrentBounds);
-        Bounds = PastBounds[0];
+        AsyncCullTick = -1;
     }
-    else
+    // The worker is idle, so the game thread may update the culling state.
+    if (AsyncCullTick < 0 && PrepareCull())
+    {
+        std::copy(
+            &VisibilityTimers[0][0],
+            &VisibilityTimers[0][0] + MAX_CHARACTERS * MAX_CHARACTERS,
+            &AsyncVisibilityTimers[0][0]);
+        AsyncCullTick = TotalTicks;
+        Worker->Start();
+    }
+}
+
+void ACullingController::PublishResults()
+{
+    VisibilityResults& Back = Results[1 - FrontResults];
+    Back.Tick = CullTick;
+    Back.DeferredPairs = CullDeferredPairs;
+    Back.OverranBudget = CullOverranBudget;
+    std::fill(
+        &Back.Visible[0][0],
+        &Back.Visible[0][0] + MAX_CHARACTERS * MAX_CHARACTERS,
+        false);
+    for (const Bundle& B : BundleQueue)
+    {
+        Back.Visible[B.PlayerI][B.EnemyI] = true;
+    }
+    BundleQueue.clear();
+}
+
+void ACullingController::UpdateCharacterBounds()
+{
+    bool PollAll = !UseMovementQueue;
+    if (PastBounds.GetNumCharacters() != Characters.size())
+    {
+        PastBounds.Reset(
+            CULLING_SIMULATED_LATENCY > 0 ? BOUNDS_HISTORY_LENGTH : 1,
+            Characters.size());
+        Bounds.Resize(Characters.size());
+        PendingMovements.resize(Characters.size());
+        HasPendingMovement.assign(Characters.size(), false);
+        // Seed the history, as characters only push after moving.
+        PollAll = true;
+    }
+    if (PollAll)
     {
         for (int i = 0; i < Characters.size(); i++)
         {
             if (IsAlive[i])
             {
-                Bounds.emplace(
-                    Bounds.begin() + i,
-                    CharacterBounds(
-                        Characters[i]->GetFirstPersonCameraComponent()->GetComponentLocation(),
-                        Characters[i]->GetActorTransform()));
+                PendingMovements[i] =
+                {
+                    i,
+                    int32(GFrameCounter),
+                    Characters[i]->GetFirstPersonCameraComponent()->GetComponentLocation(),
+                    Characters[i]->GetActorTransform(),
+                    Characters[i]->GetVelocity()
+                };
+                HasPendingMovement[i] = true;
             }
         }
     }
+    // Drain the queue even when polling so that it does not grow,
+    // keeping only the latest movement of each character.
+    MovementRecord Record;
+    while (Movements.Dequeue(Record))
+    {
+        int i = Record.Id;
+        if (UseMovementQueue
+            && IsAlive[i]
+            && (!HasPendingMovement[i] || Record.Tick >= PendingMovements[i].Tick))
+        {
+            PendingMovements[i] = Record;
+            HasPendingMovement[i] = true;
+        }
+    }
+    CameraLocations.clear();
+    Transforms.clear();
+    RecordedBounds.clear();
+    for (int i = 0; i < Characters.size(); i++)
+    {
+        if (HasPendingMovement[i])
+        {
+            CameraLocations.emplace_back(PendingMovements[i].CameraLocation);
+            Transforms.emplace_back(PendingMovements[i].Transform);
+            CharacterBounds& Recorded = PastBounds.Record(i, CullTick);
+            Recorded.Velocity = PendingMovements[i].Velocity;
+            RecordedBounds.emplace_back(&Recorded);
+            HasPendingMovement[i] = false;
+        }
+    }
+    BuildCharacterBounds(
+        RecordedBounds.size(),
+        CameraLocations.data(),
+        Transforms.data(),
+        RecordedBounds.data());
+    // This block simulates latency for testing. Remove in production.
+    // Note that this simulation differs subtly from the real setting,
+    // as a real server defines the exact location of all players
+    // that are not controlled by the client that it is culling for.
+    // In this simulation, the game displays the current positions of enemies,
+    // but the server calculates LOS with positions delayed by the latency
+    // of each character's client.
+    for (int i = 0; i < Characters.size(); i++)
+    {
+        if (!PastBounds.IsRecorded(i))
+        {
+            continue;
+        }
+        int Delay = 0;
+        if (CULLING_SIMULATED_LATENCY > 0)
+        {
+            Delay = FMath::Min(
+                FMath::RoundToInt(GetLatency(i) * SERVER_TICKRATE),
+                BOUNDS_HISTORY_LENGTH - 1);
+        }
+        Bounds.Set(PastBounds, i, CullTick - Delay);
+    }
 }
 
 void ACullingController::PopulateBundles()
 {
     BundleQueue.clear();
+    bool UseCells = CellGraph.NumCells() > 0;
+    if (UseCells)
+    {
+        EnemyCells.clear();
+        for (int j = 0; j < Characters.size(); j++)
+        {
+            EnemyCells.emplace_back(IsAlive[j] ? CellGraph.FindCell(Bounds[j]) : -1);
+        }
+    }
+    bool UsePVS = PVS.IsLoaded();
+    if (UsePVS)
+    {
+        EnemyPVSCells.clear();
+        for (int j = 0; j < Characters.size(); j++)
+        {
+            int Cell = -1;
+            if (IsAlive[j])
+            {
+                const CharacterBounds& B = Bounds[j];
+                FBox Box = FBox(B.TopVertices, 4)
+                    + FBox(B.BottomVertices, 4);
+                FVector Extent = (Box.Max - B.Center).ComponentMax(B.Center - Box.Min);
+                if (PVS.CoversMargin(FMath::Max(Extent.X, Extent.Y), Extent.Z))
+                {
+                    Cell = PVS.FindCell(B.Center);
+                }
+            }
+            EnemyPVSCells.emplace_back(Cell);
+        }
+    }
+    if (UseSquadCulling)
+    {
+        BuildSquads();
+    }
+    // Asynchronous culls also cull pairs whose timers may run out before
+    // the next cull's results arrive.
+    int TimerSlack = UseAsyncCulling ? 2 * AsyncCullingDelay : 0;
     for (int i = 0; i < Characters.size(); i++)
     {
-        if (IsAlive[i])
+        // Pairs deferred by the last cull are due on every tick.
+        bool CullingTick = IsCullingTick(i);
+        if (IsAlive[i] && (CullingTick || DeferredCounts[i] > 0))
         {
-            // TODO:
-            //   Make displacement a function of game physics and state.
-            float Latency = GetLatency(i);
-            float MaxHorizontalDisplacement = Latency * 350;
-            float MaxVerticalDisplacement = Latency * 200;
+            const FBox& Displacements = PeekDisplacements[i];
+            FVector MaxDisplacement = Displacements.Max.ComponentMax(-Displacements.Min);
+            // The cell must contain every possible peek.
+            int PlayerCell = -1;
+            if (UseCells)
+            {
+                PlayerCell = CellGraph.FindCell(Bounds[i].CameraLocation, MaxDisplacement.Size());
+            }
+            // The expanded PVS cell must also contain every possible peek.
+            int PlayerPVSCell = -1;
+            if (UsePVS
+                && PVS.CoversMargin(
+                    FMath::Max(MaxDisplacement.X, MaxDisplacement.Y),
+                    MaxDisplacement.Z))
+            {
+                PlayerPVSCell = PVS.FindCell(Bounds[i].CameraLocation);
+            }
             for (int j = 0; j < Characters.size(); j++)
             {
-                if (VisibilityTimers[i][j] == 0
+                // Deferred pairs may have been revealed, resetting their
+                // timers, but must still be culled.
+                if (((CullingTick && GetCullTimer(i, j) <= TimerSlack) || IsDeferred[i][j])
                     && IsAlive[j]
                     && (Teams[i] != Teams[j]))
                 {
-                    BundleQueue.emplace_back(
-                        Bundle(
-                            i,
-                            j,
-                            GetPossiblePeeks(
-                                Bounds[i].CameraLocation,
-                                Bounds[j].Center,
-                                MaxHorizontalDisplacement,
-                                MaxVerticalDisplacement)));
+                    if (PlayerCell >= 0
+                        && EnemyCells[j] >= 0
+                        && !CellGraph.CanSee(PlayerCell, EnemyCells[j]))
+                    {
+                        continue;
+                    }
+                    if (PlayerPVSCell >= 0
+                        && EnemyPVSCells[j] >= 0
+                        && !PVS.CanSee(PlayerPVSCell, EnemyPVSCells[j]))
+                    {
+                        continue;
+                    }
+                    std::vector<FVector> Peeks = GetPossiblePeeks(
+                        Bounds[i].CameraLocation,
+                        Bounds[j].Center,
+                        Displacements,
+                        SelectNumPeeks(Bounds[i].CameraLocation, Bounds[j].Center, Displacements));
+                    // The cuboid that last blocked the pair still blocks it.
+                    if (UseValidityHorizon && IsWithinValidityHorizon(i, j, Peeks))
+                    {
+                        continue;
+                    }
+                    // A cuboid blocks the pair's squads, so it blocks the pair.
+                    const Cuboid* SquadBlocker =
+                        UseSquadCulling ? FindSquadBlocker(Squads[i], Squads[j]) : NULL;
+                    if (SquadBlocker != NULL)
+                    {
+                        CacheCuboid(Bundle(i, j, Peeks), SquadBlocker);
+                        continue;
+                    }
+                    ValidityMargins[i][j] = 0;
+                    Bundle B(i, j, Peeks);
+                    if (UseBoundsLOD
+                        && FVector::DistSquared(Bounds[i].CameraLocation, Bounds[j].Center)
+                            > BoundsLODDistance * BoundsLODDistance)
+                    {
+                        B.HasBillboard = MakeBillboard(Peeks, Bounds[j], B.BillboardVertices);
+                    }
+                    BundleQueue.emplace_back(B);
                 }
             }
         }
     }
 }
 
+void ACullingController::BuildSquads()
+{
+    Squads.assign(Characters.size(), -1);
+    SquadSizes.clear();
+    SquadPeekBoxes.clear();
+    SquadBoxes.clear();
+    for (int i = 0; i < Characters.size(); i++)
+    {
+        if (!IsAlive[i] || Squads[i] >= 0)
+        {
+            continue;
+        }
+        int Squad = SquadSizes.size();
+        SquadSizes.emplace_back(0);
+        SquadPeekBoxes.emplace_back(FBox(ForceInit));
+        SquadBoxes.emplace_back(FBox(ForceInit));
+        for (int j = i; j < Characters.size(); j++)
+        {
+            if (!IsAlive[j]
+                || Squads[j] >= 0
+                || Teams[j] != Teams[i]
+                || FVector::Dist(Bounds[i].Center, Bounds[j].Center) > SquadRadius)
+            {
+                continue;
+            }
+            Squads[j] = Squad;
+            SquadSizes[Squad]++;
+            // Peeks toward every enemy lie within the box of displacements.
+            const FBox& Displacements = PeekDisplacements[j];
+            SquadPeekBoxes[Squad] += FBox(
+                Bounds[j].CameraLocation + Displacements.Min,
+                Bounds[j].CameraLocation + Displacements.Max);
+            SquadBoxes[Squad] += FBox(Bounds[j].TopVertices, 4);
+            SquadBoxes[Squad] += FBox(Bounds[j].BottomVertices, 4);
+        }
+    }
+    SquadBlockers.assign(SquadSizes.size() * SquadSizes.size(), NULL);
+    SquadTested.assign(SquadSizes.size() * SquadSizes.size(), false);
+}
+
+const Cuboid* ACullingController::FindSquadBlocker(int a, int b)
+{
+    if ((SquadSizes[a] == 1 && SquadSizes[b] == 1) || !CuboidTraverser)
+    {
+        return NULL;
+    }
+    int Index = a * SquadSizes.size() + b;
+    if (!SquadTested[Index])
+    {
+        SquadTested[Index] = true;
+        const FBox& PeekBox = SquadPeekBoxes[a];
+        std::vector<FVector> Peeks;
+        for (int k = 0; k < 8; k++)
+        {
+            Peeks.emplace_back(FVector(
+                (k & 1) ? PeekBox.Max.X : PeekBox.Min.X,
+                (k & 2) ? PeekBox.Max.Y : PeekBox.Min.Y,
+                (k & 4) ? PeekBox.Max.Z : PeekBox.Min.Z));
+        }
+        CharacterBounds Enemies(SquadBoxes[b]);
+        // Every blocking cuboid intersects the segment between the centers,
+        // which lies inside the hull of the peeks and the enemies' boxes.
+        OptSegment Segment(PeekBox.GetCenter(), Enemies.Center);
+        SquadBlockers[Index] = CuboidTraverser->traverse(
+            Segment,
+            [&](const Cuboid* C) -> const Cuboid*
+            {
+                return IsBlockingHull(Peeks, Enemies, C) ? C : NULL;
+            });
+    }
+    return SquadBlockers[Index];
+}
+
 // Estimates the latency of the client controlling character i in seconds.
 // The estimate should be greater than the expected latency,
 // as underestimating latency results in underestimated peeks,
 // which could result in popping.
-// TODO:
-//   Integrate with server latency estimation tools.
 float ACullingController::GetLatency(int i)
 {
+    if (UseLatencyEstimator)
+    {
+        return Latencies.GetLatency(i);
+    }
     return float(CULLING_SIMULATED_LATENCY) / SERVER_TICKRATE;
 }
 
+void ACullingController::UpdateLatencies()
+{
+    if (CullingPeriods.size() != Characters.size())
+    {
+        CullingPeriods.assign(Characters.size(), CullingPeriod);
+        Latencies.Reset(Characters.size(), float(CULLING_SIMULATED_LATENCY) / SERVER_TICKRATE);
+        if (SimulateLatencySamples)
+        {
+            LatencySource = std::make_unique<SimulatedLatencySource>(
+                float(CULLING_SIMULATED_LATENCY) / SERVER_TICKRATE);
+        }
+        else
+        {
+            LatencySource = std::make_unique<PlayerStateLatencySource>(Characters);
+        }
+    }
+    if (!UseLatencyEstimator
+        || CullTick / LatencySampleInterval == PreviousCullTick / LatencySampleInterval)
+    {
+        return;
+    }
+    Latencies.Percentile = LatencyPercentile;
+    Latencies.Margin = LatencyMargin;
+    Latencies.Update(*LatencySource);
+    for (int i = 0; i < Characters.size(); i++)
+    {
+        int Slack = FMath::FloorToInt((PeekTimeBudget - GetLatency(i)) * SERVER_TICKRATE);
+        CullingPeriods[i] = FMath::Clamp(Slack, 1, MaxCullingPeriod);
+    }
+}
+
+bool ACullingController::IsCullingTick(int i) const
+{
+    // Offset each player's ticks to spread culling work across ticks.
+    int Period = AdaptiveCullingPeriods ? CullingPeriods[i] : CullingPeriod;
+    int Offset = AdaptiveCullingPeriods ? i : 0;
+    // Asynchronous culls start several ticks apart, so check every tick
+    // since the previous cull.
+    for (int t = PreviousCullTick + 1; t <= CullTick; t++)
+    {
+        if (((t + Offset) % Period) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+float ACullingController::GetPeekTime(int i)
+{
+    float Latency = GetLatency(i);
+    if (UseAsyncCulling)
+    {
+        Latency += float(AsyncCullingDelay) / SERVER_TICKRATE;
+    }
+    if (!AdaptiveCullingPeriods)
+    {
+        return Latency;
+    }
+    return Latency + float(CullingPeriods[i]) / SERVER_TICKRATE;
+}
+
+int ACullingController::GetVisibilityTimerMax(int i) const
+{
+    int TimerMax = AdaptiveCullingPeriods ? CullingPeriods[i] * 3 : VisibilityTimerMax;
+    // Cover the wait for the next asynchronous cull and its results.
+    return UseAsyncCulling ? TimerMax + 2 * AsyncCullingDelay : TimerMax;
+}
+
+FBox ACullingController::GetPeekDisplacements(int i)
+{
+    float T = GetPeekTime(i);
+    const UCharacterMovementComponent* Movement = Characters[i]->GetCharacterMovement();
+    if (!UseVelocityPeeks || Movement == NULL)
+    {
+        FVector Extent(T * 350, T * 350, T * 200);
+        return FBox(-Extent, Extent);
+    }
+    const FVector& Velocity = Bounds[i].Velocity;
+    float Speed = Velocity.Size2D();
+    // Horizontally, the camera drifts by Velocity * T, and input can push it
+    // away from that by half of its acceleration times T squared. Friction
+    // turns the velocity toward the input, changing each component by up to
+    // twice the speed times the friction per second. Braking only opposes
+    // the current velocity, so it extends the box only behind the motion.
+    // Speed never exceeds the greater of the maximum speed and the current
+    // speed.
+    float Friction = FMath::Max(Movement->GroundFriction, Movement->FallingLateralFriction);
+    float Acceleration = Movement->GetMaxAcceleration() + 2 * Friction * Speed;
+    float Braking = FMath::Max(
+        Movement->BrakingDecelerationWalking
+            + Movement->BrakingFrictionFactor * Movement->GroundFriction * Speed,
+        Movement->BrakingDecelerationFalling
+            + Movement->BrakingFrictionFactor * Movement->FallingLateralFriction * Speed);
+    float Accelerate = 0.5f * Acceleration * T * T;
+    float Brake = 0.5f * (Acceleration + Braking) * T * T;
+    float Cap = FMath::Max(Movement->GetMaxSpeed(), Speed) * T;
+    FVector Min, Max;
+    for (int k = 0; k < 2; k++)
+    {
+        float Drift = Velocity[k] * T;
+        Min[k] = FMath::Max(Drift - (Velocity[k] > 0 ? Brake : Accelerate), -Cap);
+        Max[k] = FMath::Min(Drift + (Velocity[k] < 0 ? Brake : Accelerate), Cap);
+    }
+    // Vertically, the camera can rise until gravity stops it, starting from
+    // the current vertical speed or a jump, and fall from a ledge or an
+    // ongoing fall. Crouching or standing up moves it instantly.
+    float Gravity = FMath::Max(FMath::Abs(Movement->GetGravityZ()), 1.0f);
+    float RiseSpeed = Velocity.Z;
+    if (Characters[i]->CanJump())
+    {
+        RiseSpeed = FMath::Max(RiseSpeed, Movement->JumpZVelocity);
+    }
+    float RiseTime = FMath::Clamp(RiseSpeed / Gravity, 0.0f, T);
+    Max.Z = RiseSpeed * RiseTime - 0.5f * Gravity * RiseTime * RiseTime;
+    Min.Z = FMath::Min(0.0f, FMath::Min(Velocity.Z, 0.0f) * T - 0.5f * Gravity * T * T);
+    if (Movement->CanEverCrouch())
+    {
+        float CrouchDrop =
+            Characters[i]->GetDefaultHalfHeight() - Movement->CrouchedHalfHeight;
+        if (Characters[i]->bIsCrouched)
+        {
+            Max.Z += CrouchDrop;
+        }
+        else
+        {
+            Min.Z -= CrouchDrop;
+        }
+    }
+    return FBox(Min, Max);
+}
+
 std::vector<FVector> ACullingController::GetPossiblePeeks(
     const FVector& PlayerCameraLocation,
     const FVector& EnemyLocation,
-    float MaxDeltaHorizontal,
-    float MaxDeltaVertical)
+    const FBox& Displacements,
+    int NumPeeks)
 {
     std::vector<FVector> Corners;
+    const FVector& Min = Displacements.Min;
+    const FVector& Max = Displacements.Max;
+    FVector Center = Displacements.GetCenter();
+    if (NumPeeks == 2)
+    {
+        Corners.emplace_back(PlayerCameraLocation + FVector(Center.X, Center.Y, Max.Z));
+        Corners.emplace_back(PlayerCameraLocation + FVector(Center.X, Center.Y, Min.Z));
+        return Corners;
+    }
+    if (NumPeeks == 8)
+    {
+        const int Signs[4][2] = { { 1, 1 }, { 1, 0 }, { 0, 0 }, { 0, 1 } };
+        for (int Top = 1; Top >= 0; Top--)
+        {
+            for (int k = 0; k < 4; k++)
+            {
+                // Walk the bottom corners in reverse to keep corner k above 7 - k.
+                int c = Top ? k : 3 - k;
+                Corners.emplace_back(
+                    PlayerCameraLocation
+                    + FVector(
+                        Signs[c][0] ? Max.X : Min.X,
+                        Signs[c][1] ? Max.Y : Min.Y,
+                        Top ? Max.Z : Min.Z));
+            }
+        }
+        return Corners;
+    }
     FVector PlayerToEnemy =
         (EnemyLocation - PlayerCameraLocation).GetSafeNormal(1e-6);
-    // Displacement parallel to the XY plane and perpendicular to PlayerToEnemy.
-    FVector Horizontal =
-        MaxDeltaHorizontal * FVector(-PlayerToEnemy.Y, PlayerToEnemy.X, 0);
-    FVector Vertical = FVector(0, 0, MaxDeltaVertical);
-    Corners.emplace_back(PlayerCameraLocation + Horizontal + Vertical);
-    Corners.emplace_back(PlayerCameraLocation - Horizontal + Vertical);
-    Corners.emplace_back(PlayerCameraLocation - Horizontal - Vertical);
-    Corners.emplace_back(PlayerCameraLocation + Horizontal - Vertical);
+    // Unit vector parallel to the XY plane and perpendicular to PlayerToEnemy.
+    FVector Side = FVector(-PlayerToEnemy.Y, PlayerToEnemy.X, 0).GetSafeNormal(1e-6);
+    FVector Forward = FVector(Side.Y, -Side.X, 0);
+    // Span the sideways extent of the displacements, and move the rectangle
+    // along the line of sight with the center of the displacements.
+    float SideMin = std::numeric_limits<float>::infinity();
+    float SideMax = -SideMin;
+    for (int k = 0; k < 4; k++)
+    {
+        float Offset = Side | FVector((k & 1) ? Max.X : Min.X, (k & 2) ? Max.Y : Min.Y, 0);
+        SideMin = std::min(SideMin, Offset);
+        SideMax = std::max(SideMax, Offset);
+    }
+    FVector Base = PlayerCameraLocation + (Forward | Center) * Forward;
+    Corners.emplace_back(Base + SideMax * Side + FVector(0, 0, Max.Z));
+    Corners.emplace_back(Base + SideMin * Side + FVector(0, 0, Max.Z));
+    Corners.emplace_back(Base + SideMin * Side + FVector(0, 0, Min.Z));
+    Corners.emplace_back(Base + SideMax * Side + FVector(0, 0, Min.Z));
     return Corners;
 }
 
+int ACullingController::SelectNumPeeks(
+    const FVector& PlayerCameraLocation,
+    const FVector& EnemyLocation,
+    const FBox& Displacements)
+{
+    if (!SelectPeekCounts)
+    {
+        return NUM_PEEKS;
+    }
+    // Two peeks only cover the box if it has no horizontal extent.
+    if (Displacements.Min.X == Displacements.Max.X
+        && Displacements.Min.Y == Displacements.Max.Y)
+    {
+        return 2;
+    }
+    FVector MaxDisplacement = Displacements.Max.ComponentMax(-Displacements.Min);
+    float MaxDeltaHorizontal = FMath::Max(MaxDisplacement.X, MaxDisplacement.Y);
+    if (MaxDeltaHorizontal > EightPeekFraction * FVector::DistXY(PlayerCameraLocation, EnemyLocation))
+    {
+        return 8;
+    }
+    return NUM_PEEKS;
+}
+
 void ACullingController::CullWithCache()
 {
     std::vector<Bundle> Remaining;
@@ -219,16 +1042,14 @@ void ACullingController::CullWithCache()
         bool Blocked = false;
         for (int k = 0; k < CUBOID_CACHE_SIZE; k++)
         {
-            if (CuboidCaches[B.PlayerI][B.EnemyI][k] != NULL)
+            const Cuboid* C = CuboidCaches[B.PlayerI][B.EnemyI][k];
+            if (C != NULL)
             {
-                if (
-                    IsBlocking(
-                        B.PossiblePeeks,
-                        Bounds[B.EnemyI],
-                        CuboidCaches[B.PlayerI][B.EnemyI][k]))
+                if (Blocks(B, C))
                 {
                     Blocked = true;
-                    CacheTimers[B.PlayerI][B.EnemyI][k] = TotalTicks;
+                    CacheTimers[B.PlayerI][B.EnemyI][k] = CullTick;
+                    SetValidityHorizon(B, C);
                     break;
                 }
             }
@@ -241,6 +1062,34 @@ void ACullingController::CullWithCache()
     BundleQueue = Remaining;
 }
 
+void ACullingController::CullWithHints()
+{
+    std::vector<Bundle> Remaining;
+    for (Bundle B : BundleQueue)
+    {
+        const Cuboid* const* Hinted =
+            Hints.Find(GetPeekCenter(B.PlayerI), Bounds[B.EnemyI].Center);
+        const Cuboid* Blocker = NULL;
+        for (int k = 0; Hinted != NULL && k < HINTS_PER_KEY && Blocker == NULL; k++)
+        {
+            if (Hinted[k] != NULL && Blocks(B, Hinted[k]))
+            {
+                Blocker = Hinted[k];
+            }
+        }
+        if (Blocker != NULL)
+        {
+            Hints.Hits++;
+            CacheCuboid(B, Blocker);
+        }
+        else
+        {
+            Remaining.emplace_back(B);
+        }
+    }
+    BundleQueue = Remaining;
+}
+
 void ACullingController::CullWithSpheres()
 {
     std::vector<Bundle> Remaining;
@@ -272,19 +1121,10 @@ void ACullingController::CullWithCuboids()
     std::vector<Bundle> Remaining;
     for (Bundle B : BundleQueue)
     {
-        const Cuboid* CuboidP = CuboidTraverser.get()->traverse(
-            OptSegment(
-                Bounds[B.PlayerI].CameraLocation,
-                Bounds[B.EnemyI].Center),
-            B.PossiblePeeks,
-            Bounds[B.EnemyI]);
+        const Cuboid* CuboidP = FindBlockingCuboid(B, Accelerator);
         if (CuboidP != NULL)
         {
-            int MinI = ArgMin(
-                CacheTimers[B.PlayerI][B.EnemyI],
-                CUBOID_CACHE_SIZE);
-            CuboidCaches[B.PlayerI][B.EnemyI][MinI] = CuboidP;
-            CacheTimers[B.PlayerI][B.EnemyI][MinI] = TotalTicks;
+            CacheCuboid(B, CuboidP);
         }
         else
         {
@@ -294,6 +1134,514 @@ void ACullingController::CullWithCuboids()
     BundleQueue = Remaining;
 }
 
+const Cuboid* ACullingController::FindBlockingCuboid(
+    const Bundle& B,
+    EOccluderAccelerator Structure)
+{
+    // Like the other stages, trace from the center of the peeks, which any
+    // cuboid that blocks every peek also blocks.
+    OptSegment Segment(GetPeekCenter(B.PlayerI), Bounds[B.EnemyI].Center);
+    // Fusion assumes the default blocking test, so other tests are passed in.
+    if (!UsesDefaultTest(B))
+    {
+        auto BlocksBundle = [&](const Cuboid* C) -> const Cuboid*
+        {
+            return Blocks(B, C) ? C : NULL;
+        };
+        if (Structure == EOccluderAccelerator::Grid && Grid.IsBuilt())
+        {
+            return Grid.Traverse(Segment, BlocksBundle);
+        }
+        if (Structure == EOccluderAccelerator::CompactBVH && CompactCuboidBVH)
+        {
+            return CompactCuboidBVH->traverse(Segment, BlocksBundle);
+        }
+        return CuboidTraverser.get()->traverse(Segment, BlocksBundle);
+    }
+    if (Structure == EOccluderAccelerator::Grid && Grid.IsBuilt())
+    {
+        return Grid.Traverse(Segment, B.PossiblePeeks, Bounds[B.EnemyI]);
+    }
+    if (Structure == EOccluderAccelerator::CompactBVH && CompactCuboidBVH)
+    {
+        return CompactCuboidBVH->traverse(Segment, B.PossiblePeeks, Bounds[B.EnemyI]);
+    }
+    return CuboidTraverser.get()->traverse(Segment, B.PossiblePeeks, Bounds[B.EnemyI]);
+}
+
+void ACullingController::CompareNodeOrders()
+{
+    std::vector<OptSegment> Segments;
+    for (ACornerCullingCharacter* A : Characters)
+    {
+        for (ACornerCullingCharacter* B : Characters)
+        {
+            if (A != B)
+            {
+                Segments.emplace_back(OptSegment(A->GetActorLocation(), B->GetActorLocation()));
+            }
+        }
+    }
+    const FastBVH::BBox<float>& Root = CuboidBVH->getNodes()[0].bbox;
+    FBox RootBox(
+        FVector(Root.min.x, Root.min.y, Root.min.z),
+        FVector(Root.max.x, Root.max.y, Root.max.z));
+    FRandomStream Stream(0);
+    for (int i = 0; i < 1000; i++)
+    {
+        Segments.emplace_back(
+            OptSegment(
+                Stream.RandPointInBox(RootBox),
+                Stream.RandPointInBox(RootBox)));
+    }
+    FastBVH::NodeArray<float> Reordered = FastBVH::reorderNodes(CuboidBVH->getNodes());
+    const FastBVH::ConstIterable<FastBVH::Node<float>> Orders[] =
+    {
+        CuboidBVH->getNodes(),
+        FastBVH::ConstIterable<FastBVH::Node<float>>(Reordered.data(), Reordered.size())
+    };
+    const TCHAR* Names[] = { TEXT("Build order"), TEXT("Reordered") };
+    // Typical L1 and L2 data cache sizes.
+    const uint32 CacheSizes[] = { 32 << 10, 256 << 10 };
+    std::vector<uint32_t> Trace;
+    for (int o = 0; o < 2; o++)
+    {
+        for (uint32 CacheSize : CacheSizes)
+        {
+            FastBVH::CacheSimulator Cache(CacheSize);
+            for (const OptSegment& Segment : Segments)
+            {
+                Trace.clear();
+                FastBVH::traceNodes(Orders[o], Segment, Trace);
+                for (uint32_t Node : Trace)
+                {
+                    Cache.read(uint64(Node) * sizeof(FastBVH::Node<float>), sizeof(FastBVH::Node<float>));
+                }
+            }
+            UE_LOG(
+                LogCulling,
+                Log,
+                TEXT("%s: %.1f misses per traversal in a %d KB cache (%.1f lines read)."),
+                Names[o],
+                float(Cache.misses) / Segments.size(),
+                int(CacheSize >> 10),
+                float(Cache.reads) / Segments.size());
+        }
+    }
+}
+
+void ACullingController::CompareAccelerators()
+{
+    if (!CuboidTraverser || !Grid.IsBuilt() || !CompactCuboidBVH)
+    {
+        return;
+    }
+    const EOccluderAccelerator Structures[] =
+    {
+        EOccluderAccelerator::BVH,
+        EOccluderAccelerator::CompactBVH,
+        EOccluderAccelerator::Grid
+    };
+    const TCHAR* Names[] = { TEXT("BVH"), TEXT("CompactBVH"), TEXT("Grid") };
+    for (int s = 0; s < 3; s++)
+    {
+        int Blocked = 0;
+        auto Start = std::chrono::high_resolution_clock::now();
+        for (const Bundle& B : BundleQueue)
+        {
+            Blocked += FindBlockingCuboid(B, Structures[s]) != NULL;
+        }
+        auto Stop = std::chrono::high_resolution_clock::now();
+        int Delta = std::chrono::duration_cast<std::chrono::microseconds>(Stop - Start).count();
+        UE_LOG(
+            LogCulling,
+            Log,
+            TEXT("%s: %s culled %d of %d bundles in %d microseconds."),
+            *GetWorld()->GetMapName(),
+            Names[s],
+            Blocked,
+            int(BundleQueue.size()),
+            Delta);
+        if (GEngine)
+        {
+            FString Msg = FString(Names[s]) + " time to cull bundles (microseconds): "
+                + FString::FromInt(Delta);
+            GEngine->AddOnScreenDebugMessage(4 + s, 2.0f, FColor::Yellow, Msg, true, FVector2D(2.0f, 2.0f));
+        }
+    }
+}
+
+bool ACullingController::UsesDefaultTest(const Bundle& B) const
+{
+    return !UseHullBlocking && !B.HasBillboard && B.PossiblePeeks.size() == NUM_PEEKS;
+}
+
+bool ACullingController::Blocks(const Bundle& B, const Cuboid* C) const
+{
+    if (UseHullBlocking)
+    {
+        return IsBlockingHull(B.PossiblePeeks, Bounds[B.EnemyI], C);
+    }
+    if (B.HasBillboard)
+    {
+        return IsBlockingBillboard(B, C);
+    }
+    return IsBlocking(B.PossiblePeeks, Bounds[B.EnemyI], C);
+}
+
+void ACullingController::CompareBlockingKernels()
+{
+    if (!CuboidTraverser)
+    {
+        return;
+    }
+    int Tests = 0;
+    int SegmentBlocked = 0;
+    int HullBlocked = 0;
+    int Disagreements = 0;
+    int SegmentTime = 0;
+    int HullTime = 0;
+    int Start = 0;
+    while (Start < BundleQueue.size())
+    {
+        FBox Source;
+        int End = GatherNearbyCuboids(Start, Source);
+        auto Time0 = std::chrono::high_resolution_clock::now();
+        for (int b = Start; b < End; b++)
+        {
+            for (const Cuboid* C : NearbyCuboids)
+            {
+                SegmentBlocked += IsBlocking(BundleQueue[b].PossiblePeeks, Bounds[BundleQueue[b].EnemyI], C);
+            }
+        }
+        auto Time1 = std::chrono::high_resolution_clock::now();
+        for (int b = Start; b < End; b++)
+        {
+            for (const Cuboid* C : NearbyCuboids)
+            {
+                HullBlocked += IsBlockingHull(BundleQueue[b].PossiblePeeks, Bounds[BundleQueue[b].EnemyI], C);
+            }
+        }
+        auto Time2 = std::chrono::high_resolution_clock::now();
+        SegmentTime += std::chrono::duration_cast<std::chrono::microseconds>(Time1 - Time0).count();
+        HullTime += std::chrono::duration_cast<std::chrono::microseconds>(Time2 - Time1).count();
+        for (int b = Start; b < End; b++)
+        {
+            const Bundle& B = BundleQueue[b];
+            for (const Cuboid* C : NearbyCuboids)
+            {
+                Disagreements +=
+                    IsBlocking(B.PossiblePeeks, Bounds[B.EnemyI], C)
+                    != IsBlockingHull(B.PossiblePeeks, Bounds[B.EnemyI], C);
+            }
+            Tests += NearbyCuboids.size();
+        }
+        Start = End;
+    }
+    UE_LOG(
+        LogCulling,
+        Log,
+        TEXT("%s: %d blocking tests. Segments: %d blocked in %d microseconds. Hull: %d blocked in %d microseconds. %d disagreements."),
+        *GetWorld()->GetMapName(),
+        Tests,
+        SegmentBlocked,
+        SegmentTime,
+        HullBlocked,
+        HullTime,
+        Disagreements);
+    if (GEngine)
+    {
+        FString Msg = "Blocking tests (segments/hull microseconds, disagreements): "
+            + FString::FromInt(SegmentTime) + "/" + FString::FromInt(HullTime)
+            + ", " + FString::FromInt(Disagreements);
+        GEngine->AddOnScreenDebugMessage(7, 2.0f, FColor::Yellow, Msg, true, FVector2D(2.0f, 2.0f));
+    }
+}
+
+void ACullingController::CacheCuboid(const Bundle& B, const Cuboid* C)
+{
+    int MinI = ArgMin(CacheTimers[B.PlayerI][B.EnemyI], CUBOID_CACHE_SIZE);
+    CuboidCaches[B.PlayerI][B.EnemyI][MinI] = C;
+    CacheTimers[B.PlayerI][B.EnemyI][MinI] = CullTick;
+    SetValidityHorizon(B, C);
+    if (UseOccluderHints)
+    {
+        Hints.Insert(GetPeekCenter(B.PlayerI), Bounds[B.EnemyI].Center, C);
+    }
+}
+
+void ACullingController::SetValidityHorizon(const Bundle& B, const Cuboid* C)
+{
+    if (!UseValidityHorizon)
+    {
+        return;
+    }
+    const CharacterBounds& Enemy = Bounds[B.EnemyI];
+    ValidityMargins[B.PlayerI][B.EnemyI] = BlockingMargin(B.PossiblePeeks, Enemy, C, UseHullBlocking);
+    MarginPeekCounts[B.PlayerI][B.EnemyI] = B.PossiblePeeks.size();
+    for (int k = 0; k < B.PossiblePeeks.size(); k++)
+    {
+        MarginPeeks[B.PlayerI][B.EnemyI][k] = B.PossiblePeeks[k];
+    }
+    for (int k = 0; k < 4; k++)
+    {
+        MarginVertices[B.PlayerI][B.EnemyI][k] = Enemy.TopVertices[k];
+        MarginVertices[B.PlayerI][B.EnemyI][k + 4] = Enemy.BottomVertices[k];
+    }
+}
+
+bool ACullingController::IsWithinValidityHorizon(
+    int i,
+    int j,
+    const std::vector<FVector>& Peeks)
+{
+    float MarginSquared = ValidityMargins[i][j] * ValidityMargins[i][j];
+    if (MarginSquared == 0 || MarginPeekCounts[i][j] != Peeks.size())
+    {
+        return false;
+    }
+    for (int k = 0; k < Peeks.size(); k++)
+    {
+        if (FVector::DistSquared(Peeks[k], MarginPeeks[i][j][k]) > MarginSquared)
+        {
+            return false;
+        }
+    }
+    for (int k = 0; k < 4; k++)
+    {
+        if (FVector::DistSquared(Bounds[j].TopVertices[k], MarginVertices[i][j][k]) > MarginSquared
+            || FVector::DistSquared(Bounds[j].BottomVertices[k], MarginVertices[i][j][k + 4]) > MarginSquared)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ACullingController::CullWithDistanceField()
+{
+    std::vector<Bundle> Remaining;
+    for (const Bundle& B : BundleQueue)
+    {
+        int NearestCuboid;
+        int Result = SDF.Trace(
+            GetPeekCenter(B.PlayerI),
+            Bounds[B.EnemyI].Center,
+            DistanceFieldMinStep,
+            DistanceFieldMaxSteps,
+            NearestCuboid);
+        // The center of the peek box lies between the peeks, and the enemy's
+        // center inside its bounding box, so no single cuboid can block all
+        // lines of sight.
+        // The camera itself may lie outside of the peeks, as the box follows
+        // the player's velocity.
+        if (Result == 1)
+        {
+            VisibleBundles.emplace_back(B);
+        }
+        else if (Result == 0
+            && NearestCuboid >= 0
+            && Blocks(B, &Cuboids[NearestCuboid]))
+        {
+            CacheCuboid(B, &Cuboids[NearestCuboid]);
+        }
+        else
+        {
+            Remaining.emplace_back(B);
+        }
+    }
+    BundleQueue = Remaining;
+}
+
+// Like the rasterizer, but in 2D with walls only.
+void ACullingController::CullWithWalls()
+{
+    std::vector<Bundle> Remaining;
+    int Start = 0;
+    while (Start < BundleQueue.size())
+    {
+        FBox Source;
+        int End = GatherNearbyCuboids(Start, Source);
+        Sweep.Clear(FVector2D(GetPeekCenter(BundleQueue[Start].PlayerI)));
+        for (const Cuboid* C : NearbyCuboids)
+        {
+            int WallI = WallIndices[C - Cuboids.data()];
+            if (WallI >= 0)
+            {
+                Sweep.Insert(Walls[WallI], WallI);
+            }
+        }
+        bool PeeksInBand = Source.Min.Z >= PlayableZMin && Source.Max.Z <= PlayableZMax;
+        for (int b = Start; b < End; b++)
+        {
+            const Bundle& B = BundleQueue[b];
+            const CharacterBounds& Enemy = Bounds[B.EnemyI];
+            bool Blocked = false;
+            FVector2D Peeks[MAX_PEEKS];
+            int NumPeeks = B.PossiblePeeks.size();
+            for (int k = 0; k < NumPeeks; k++)
+            {
+                Peeks[k] = FVector2D(B.PossiblePeeks[k]);
+            }
+            FVector2D Footprint[CUBOID_V];
+            bool EnemyInBand = true;
+            for (int k = 0; k < 4; k++)
+            {
+                Footprint[k] = FVector2D(Enemy.TopVertices[k]);
+                Footprint[k + 4] = FVector2D(Enemy.BottomVertices[k]);
+                EnemyInBand &= Enemy.TopVertices[k].Z <= PlayableZMax
+                    && Enemy.BottomVertices[k].Z >= PlayableZMin;
+            }
+            // Lines of sight between points in the band stay in the band.
+            if (PeeksInBand && EnemyInBand)
+            {
+                Candidates.clear();
+                Sweep.GetCandidates(Footprint, CUBOID_V, Candidates);
+                for (int c : Candidates)
+                {
+                    if (Walls[c].Blocks(Peeks, NumPeeks, Footprint, CUBOID_V))
+                    {
+                        Blocked = true;
+                        CacheCuboid(B, Walls[c].Occluder);
+                        break;
+                    }
+                }
+            }
+            if (!Blocked)
+            {
+                Remaining.emplace_back(B);
+            }
+        }
+        Start = End;
+    }
+    BundleQueue = Remaining;
+}
+
+// Bundles are queued in order of player, so each player's bundles are
+// culled together against shadow volumes cast from the box containing
+// all of that player's peeks.
+void ACullingController::CullWithShadowVolumes()
+{
+    if (!CuboidTraverser)
+    {
+        return;
+    }
+    std::vector<Bundle> Remaining;
+    int Start = 0;
+    while (Start < BundleQueue.size())
+    {
+        FBox Source;
+        int End = GatherNearbyCuboids(Start, Source);
+        int NumVolumes = 0;
+        for (const Cuboid* C : NearbyCuboids)
+        {
+            if (ShadowVolumes.size() <= NumVolumes)
+            {
+                ShadowVolumes.emplace_back();
+            }
+            if (ShadowVolumes[NumVolumes].Build(C, Source))
+            {
+                NumVolumes++;
+            }
+        }
+        for (int b = Start; b < End; b++)
+        {
+            const Bundle& B = BundleQueue[b];
+            const CharacterBounds& Enemy = Bounds[B.EnemyI];
+            // Pack the four top and four bottom vertices into one register.
+            __m256 Xs = _mm256_blend_ps(Enemy.TopVerticesXs, Enemy.BottomVerticesXs, 0xF0);
+            __m256 Ys = _mm256_blend_ps(Enemy.TopVerticesYs, Enemy.BottomVerticesYs, 0xF0);
+            __m256 Zs = _mm256_blend_ps(Enemy.TopVerticesZs, Enemy.BottomVerticesZs, 0xF0);
+            bool Blocked = false;
+            for (int v = 0; v < NumVolumes && !Blocked; v++)
+            {
+                const ShadowVolume& Volume = ShadowVolumes[v];
+                if (Volume.MayContain(Xs, Ys, Zs)
+                    && Blocks(B, Volume.Occluder))
+                {
+                    Blocked = true;
+                    CacheCuboid(B, Volume.Occluder);
+                }
+            }
+            if (!Blocked)
+            {
+                Remaining.emplace_back(B);
+            }
+        }
+        Start = End;
+    }
+    BundleQueue = Remaining;
+}
+
+int ACullingController::GatherNearbyCuboids(int Start, FBox& Source)
+{
+    int i = BundleQueue[Start].PlayerI;
+    int End = Start;
+    Source = FBox(ForceInit);
+    FBox Region(ForceInit);
+    for (; End < BundleQueue.size() && BundleQueue[End].PlayerI == i; End++)
+    {
+        const CharacterBounds& Enemy = Bounds[BundleQueue[End].EnemyI];
+        Source += FBox(BundleQueue[End].PossiblePeeks.data(), BundleQueue[End].PossiblePeeks.size());
+        Region += FBox(Enemy.TopVertices, 4);
+        Region += FBox(Enemy.BottomVertices, 4);
+    }
+    // Occluders of these bundles lie between the peeks and the enemies.
+    Region = (Region + Source).Overlap(
+        FBox::BuildAABB(GetPeekCenter(i), FVector(NearbyCuboidRadius)));
+    NearbyCuboids.clear();
+    CuboidTraverser->gather(
+        FastBVH::BBox<float>(
+            FastBVH::Vector3<float>{ Region.Min.X, Region.Min.Y, Region.Min.Z },
+            FastBVH::Vector3<float>{ Region.Max.X, Region.Max.Y, Region.Max.Z }),
+        NearbyCuboids);
+    return End;
+}
+
+// Like CullWithShadowVolumes, rasterizes the cuboids near each player once,
+// then culls each of the player's bundles.
+void ACullingController::CullWithRasterizer()
+{
+    if (!CuboidTraverser)
+    {
+        return;
+    }
+    std::vector<Bundle> Remaining;
+    int Start = 0;
+    while (Start < BundleQueue.size())
+    {
+        FBox Source;
+        int End = GatherNearbyCuboids(Start, Source);
+        Rasterizer.Clear(GetPeekCenter(BundleQueue[Start].PlayerI));
+        for (int c = 0; c < NearbyCuboids.size(); c++)
+        {
+            Rasterizer.Rasterize(NearbyCuboids[c], c);
+        }
+        for (int b = Start; b < End; b++)
+        {
+            const Bundle& B = BundleQueue[b];
+            Candidates.clear();
+            Rasterizer.GetCandidates(Bounds[B.EnemyI], Candidates);
+            bool Blocked = false;
+            for (int c : Candidates)
+            {
+                if (Blocks(B, NearbyCuboids[c]))
+                {
+                    Blocked = true;
+                    CacheCuboid(B, NearbyCuboids[c]);
+                    break;
+                }
+            }
+            if (!Blocked)
+            {
+                Remaining.emplace_back(B);
+            }
+        }
+        Start = End;
+    }
+    BundleQueue = Remaining;
+}
+
 // Increments visibility timers of bundles that were not culled,
 // and reveals enemies with positive visibility timers.
 void ACullingController::UpdateVisibility()
@@ -301,10 +1649,14 @@ void ACullingController::UpdateVisibility()
     // There are bundles remaining from the culling pipeline.
     for (Bundle B : BundleQueue)
     {
-        VisibilityTimers[B.PlayerI][B.EnemyI] = VisibilityTimerMax;
+        VisibilityTimers[B.PlayerI][B.EnemyI] = GetVisibilityTimerMax(B.PlayerI);
     }
     BundleQueue.clear();
-    // Reveal
+    RevealEnemies();
+}
+
+void ACullingController::RevealEnemies()
+{
     for (int i = 0; i < Characters.size(); i++)
     {
         if (IsAlive[i])
@@ -9,21 +9,84 @@
 #include "DrawDebugHelpers.h"
 #include "GeometricPrimitives.h"
 #include "FastBVH.h"
+#include "OccluderFusion.h"
+#include "CellPortalGraph.h"
+#include "PotentiallyVisibleSet.h"
+#include "ShadowVolume.h"
+#include "OcclusionRasterizer.h"
+#include "WallSweep.h"
+#include "CuboidGrid.h"
+#include "DistanceField.h"
+#include "OccluderHints.h"
+#include "LatencyEstimator.h"
+#include "BoundsHistory.h"
+#include "MovementQueue.h"
+#include "CullingWorker.h"
+#include <atomic>
 #include <vector>
 #include "CullingController.generated.h"
 
+DECLARE_LOG_CATEGORY_EXTERN(LogCulling, Log, All);
 
 constexpr int SERVER_TICKRATE = 120;
 // Simulated latency in ticks.
 constexpr int CULLING_SIMULATED_LATENCY = 12;
+// Number of ticks of character bounds kept to simulate latency.
+// Latencies beyond this are clamped.
+constexpr int BOUNDS_HISTORY_LENGTH = SERVER_TICKRATE;
 
-// Number of peeks in each Bundle.
+// Default and maximum number of peeks in each Bundle.
 constexpr int NUM_PEEKS = 4;
+constexpr int MAX_PEEKS = 8;
 // Maximum number of characters in a game.
 constexpr int MAX_CHARACTERS = 100;
 // Number of cuboids in each entry of the cuboid cache array.
 constexpr int CUBOID_CACHE_SIZE = 3;
 
+// Methods of culling the bundles that remain after the cheaper stages.
+UENUM()
+enum class ECuboidCullingBackend : uint8
+{
+    // Traverse the cuboid BVH for each bundle.
+    BVH,
+    // Rasterize nearby cuboids once per player, then test each bundle
+    // against the candidates in its enemy's pixels.
+    Rasterizer
+};
+
+// Acceleration structures that find the cuboids along a line of sight.
+UENUM()
+enum class EOccluderAccelerator : uint8
+{
+    BVH,
+    // The same BVH with 32-byte quantized nodes.
+    CompactBVH,
+    // Uniform grid walked with a 3D digital differential analyzer.
+    Grid
+};
+
+// What happens to pairs that were due but left unculled when a cull ran out
+// of time.
+UENUM()
+enum class EDeferredPairPolicy : uint8
+{
+    // Reveal the enemy, which is always safe.
+    FailOpen,
+    // Reveal the enemy only if the pair was visible when last culled.
+    KeepPrevious
+};
+
+// Pairs that a cull found visible, indexed by player and enemy.
+struct VisibilityResults
+{
+    // Tick that the cull started on.
+    int Tick = -1;
+    bool Visible[MAX_CHARACTERS][MAX_CHARACTERS] = { { false } };
+    // Pairs that the cull deferred, and whether it overran its budget.
+    int DeferredPairs = 0;
+    bool OverranBudget = false;
+};
+
 /**
  *  Controls all occlusion culling logic.
  */
@@ -40,18 +103,121 @@ class ACullingController : public AInfo
     std::vector<bool> IsAlive;
     // Tracks team of each character.
     std::vector<char> Teams;
-    // Bounding volumes of all characters.
-    std::vector<CharacterBounds> Bounds;
-    // Bounding volumes of all characters at past times.
+    // Bounding volumes of all characters, each taken at the tick that
+    // the server last heard from the character's client.
+    BoundsView Bounds;
+    // Bounding volumes of all characters at each recent tick.
     // Used to simulate latency in testing.
-    std::deque<std::vector<CharacterBounds>> PastBounds;
+    BoundsHistory PastBounds;
+    // Characters push their movement here instead of being polled,
+    // and only characters that moved have their bounds recomputed.
+    UPROPERTY(EditAnywhere)
+    bool UseMovementQueue = true;
+    MovementQueue Movements;
+    // Latest movement of each character that is not yet in the history.
+    std::vector<MovementRecord> PendingMovements;
+    std::vector<bool> HasPendingMovement;
+    // Camera locations and transforms of characters that moved, and the
+    // bounds in the latest snapshot that each one sets. Reused across ticks.
+    std::vector<FVector> CameraLocations;
+    std::vector<FTransform> Transforms;
+    std::vector<CharacterBounds*> RecordedBounds;
     // Cache of pointers to cuboids that recently blocked LOS from
     // player i to enemy j. Accessed by CuboidCaches[i][j].
     const Cuboid* CuboidCaches[MAX_CHARACTERS][MAX_CHARACTERS][CUBOID_CACHE_SIZE] = { 0 };
     // Timers that track the last time a cuboid in the cache blocked LOS.
     int CacheTimers[MAX_CHARACTERS][MAX_CHARACTERS][CUBOID_CACHE_SIZE] = { 0 };
+    // Cluster nearby teammates into squads each cull, and test whether a
+    // single cuboid blocks every line of sight between two squads before
+    // building bundles for their pairs. A blocked squad pair culls all of
+    // its pairs at once and seeds their caches.
+    UPROPERTY(EditAnywhere)
+    bool UseSquadCulling = false;
+    // Greatest distance from a squad's first member to its other members.
+    UPROPERTY(EditAnywhere)
+    float SquadRadius = 600;
+    // Squad of each character, or -1 if dead.
+    std::vector<int> Squads;
+    // Number of members of each squad.
+    std::vector<int> SquadSizes;
+    // Box containing every possible peek of each squad's members.
+    std::vector<FBox> SquadPeekBoxes;
+    // Box containing the bounding boxes of each squad's members.
+    std::vector<FBox> SquadBoxes;
+    // Cuboid blocking each pair of squads, indexed by a * NumSquads + b,
+    // and whether the pair has been tested this cull.
+    std::vector<const Cuboid*> SquadBlockers;
+    std::vector<bool> SquadTested;
+    // Replace the bounding boxes of enemies beyond BoundsLODDistance with
+    // billboards, which need half as many segments per blocking test.
+    // Billboards are slightly larger than what they replace, so this only
+    // trades culling precision for speed. A single point or sphere would
+    // not contain the box, so it is never used.
+    UPROPERTY(EditAnywhere)
+    bool UseBoundsLOD = true;
+    UPROPERTY(EditAnywhere)
+    float BoundsLODDistance = 4000;
+    // Bound each player's peeks by a box swept from its current velocity,
+    // the acceleration, braking, and jumping rules of its movement component,
+    // and its latency, instead of fixed speeds.
+    UPROPERTY(EditAnywhere)
+    bool UseVelocityPeeks = true;
+    // Pick the number of peeks per pair. Players who cannot move horizontally
+    // before the server hears of it, such as rooted players, use 2 peeks
+    // stacked vertically, and players who can move far
+    // relative to the distance to their enemy use the 8 corners of a box,
+    // which, unlike the default rectangle, contains every possible peek.
+    UPROPERTY(EditAnywhere)
+    bool SelectPeekCounts = true;
+    // Fraction of the horizontal distance to the enemy above which the
+    // horizontal displacement calls for 8 peeks.
+    UPROPERTY(EditAnywhere)
+    float EightPeekFraction = 0.1;
+    // After per-pair cache misses, try cuboids that recently blocked other
+    // pairs between the same cells of the map before traversing the BVH.
+    UPROPERTY(EditAnywhere)
+    bool UseOccluderHints = true;
+    // Side length of the cells that key occluder hints.
+    UPROPERTY(EditAnywhere)
+    float HintCellSize = 400;
+    OccluderHints Hints;
+    // Test cuboids against every line of sight between the hull of a player's
+    // peeks and the whole bounding box of an enemy. Exact for any convex
+    // occluder, but twice as many segments as the default top-to-top and
+    // bottom-to-bottom test, which is exact only for vertical prisms.
+    // Disables occluder fusion, which assumes the default test.
+    UPROPERTY(EditAnywhere)
+    bool UseHullBlocking = false;
+    // Periodically compare the two blocking tests on the queued bundles and
+    // their nearby cuboids, logging time and disagreements.
+    UPROPERTY(EditAnywhere)
+    bool BenchmarkBlockingKernels = false;
+    // Re-cull a blocked pair only once its peeks or its enemy's bounding box
+    // have moved further than the depth of their lines of sight in the cuboid
+    // that blocked them.
+    UPROPERTY(EditAnywhere)
+    bool UseValidityHorizon = true;
+    // How far the peeks of player i and the bounding box vertices of enemy j
+    // can move before the cuboid that blocked them may stop blocking them.
+    // Zero if the pair must be culled from scratch.
+    float ValidityMargins[MAX_CHARACTERS][MAX_CHARACTERS] = { 0 };
+    // Peeks and enemy bounding box vertices when each margin was computed.
+    FVector MarginPeeks[MAX_CHARACTERS][MAX_CHARACTERS][MAX_PEEKS];
+    uint8 MarginPeekCounts[MAX_CHARACTERS][MAX_CHARACTERS] = { 0 };
+    FVector MarginVertices[MAX_CHARACTERS][MAX_CHARACTERS][CUBOID_V];
     // All occluding cuboids in the map.
     std::vector<Cuboid> Cuboids;
+    // Merge touching cuboids and drop contained cuboids when loading the map.
+    UPROPERTY(EditAnywhere)
+    bool SimplifyOccluders = true;
+    // Let touching cuboids jointly block a bundle. Off by default, as every
+    // cuboid the traversal reaches then computes its full mask of blocked
+    // lines of sight instead of exiting early, so enable it on maps with
+    // many touching cuboids.
+    UPROPERTY(EditAnywhere)
+    bool FuseOccluders = false;
+    // Joint cuboids of touching cuboids, used when fusing occluders.
+    OccluderFusion Fusion;
     // Bounding volume hierarchy containing cuboids.
     std::unique_ptr<FastBVH::BVH<float, Cuboid>> CuboidBVH{};
     CuboidIntersector Intersector;
@@ -59,13 +225,132 @@ class ACullingController : public AInfo
     std::unique_ptr
         <Traverser<float, decltype(Intersector)>>
         CuboidTraverser{};
+    // Cull bundles within the playable band of heights with the footprints
+    // of walls that span the band, in 2D.
+    UPROPERTY(EditAnywhere)
+    bool UseWallSweep = false;
+    // Heights between which characters and their peeks usually stay.
+    // The band depends on the map, so set it before enabling the sweep.
+    UPROPERTY(EditAnywhere)
+    float PlayableZMin = 0;
+    UPROPERTY(EditAnywhere)
+    float PlayableZMax = 400;
+    // Cuboids that span the playable band.
+    std::vector<Wall> Walls;
+    // Index of each cuboid's wall, or -1 if the cuboid is not a wall.
+    std::vector<int> WallIndices;
+    // Angular depth buffer of walls, reused for each player.
+    WallSweep Sweep;
+    // Cull each player's bundles with the shadow volumes of nearby cuboids,
+    // built once per player, before traversing the BVH for each bundle.
+    UPROPERTY(EditAnywhere)
+    bool UseShadowVolumes = false;
+    // Only cuboids within this distance of a player are gathered to cull
+    // the player's bundles with shadow volumes or the rasterizer.
+    UPROPERTY(EditAnywhere)
+    float NearbyCuboidRadius = 3000;
+    // Reused storage for the cuboids near a player and their shadow volumes.
+    std::vector<const Cuboid*> NearbyCuboids;
+    std::vector<ShadowVolume> ShadowVolumes;
+    // Backend used to cull bundles with cuboids.
+    UPROPERTY(EditAnywhere)
+    ECuboidCullingBackend CuboidBackend = ECuboidCullingBackend::BVH;
+    // Depth and ID buffer, reused for each player.
+    OcclusionRasterizer Rasterizer;
+    // Reused storage for the candidate occluders of a bundle.
+    std::vector<int> Candidates;
+    // Lay out BVH nodes so that likely traversal paths are sequential.
+    // Helps on maps whose BVH does not fit in cache.
+    UPROPERTY(EditAnywhere)
+    bool ReorderBVH = false;
+    // Simulate the cache misses of BVH traversals with the original and
+    // reordered layouts at load, and log the results.
+    UPROPERTY(EditAnywhere)
+    bool BenchmarkNodeOrder = false;
+    // Structure used to find cuboids when culling with the BVH backend.
+    // Pick the faster one for each map with BenchmarkAccelerators.
+    UPROPERTY(EditAnywhere)
+    EOccluderAccelerator Accelerator = EOccluderAccelerator::BVH;
+    // Side length of grid cells. Non-positive values pick a size from the
+    // average size of cuboids.
+    UPROPERTY(EditAnywhere)
+    float GridCellSize = 0;
+    // Periodically time every accelerator on the queued bundles and log
+    // the results.
+    UPROPERTY(EditAnywhere)
+    bool BenchmarkAccelerators = false;
+    // Uniform grid of cuboids. Only built if used.
+    CuboidGrid Grid;
+    // Compressed copy of the cuboid BVH. Only built if used.
+    std::unique_ptr<FastBVH::CompactBVH<CuboidIntersector>> CompactCuboidBVH{};
+    // Sphere trace each bundle through a distance field of the cuboids before
+    // any BVH work. A clear segment from camera to enemy proves that no cuboid
+    // can block the bundle, and a stuck trace yields a likely occluder.
+    UPROPERTY(EditAnywhere)
+    bool UseDistanceField = false;
+    // Side length of distance field voxels. Larger voxels build faster.
+    UPROPERTY(EditAnywhere)
+    float DistanceFieldVoxelSize = 50;
+    // Memory budget of the distance field in megabytes.
+    UPROPERTY(EditAnywhere, meta = (ClampMin = "1"))
+    int DistanceFieldMemoryMB = 64;
+    // Step below which a trace counts as stuck on a cuboid, and the number
+    // of steps after which a trace gives up.
+    UPROPERTY(EditAnywhere)
+    float DistanceFieldMinStep = 1;
+    UPROPERTY(EditAnywhere)
+    int DistanceFieldMaxSteps = 64;
+    DistanceField SDF;
+    // Bundles that the distance field proved visible, which skip later stages.
+    std::vector<Bundle> VisibleBundles;
     // All occluding spheres in the map.
     std::vector<Sphere> Spheres;
+    // Cells and portals of indoor maps. Empty if the map has no cells.
+    CellPortalGraph CellGraph;
+    // Cell containing each character's bounding box, or -1 if none does.
+    std::vector<int> EnemyCells;
+    // Precomputed cell-to-cell visibility of the map. Empty if not built.
+    PotentiallyVisibleSet PVS;
+    // PVS cell containing each character's center, or -1 if the character's
+    // bounding box does not fit within the PVS margins.
+    std::vector<int> EnemyPVSCells;
     // Queues of line-of-sight bundles needing to be culled.
     std::vector<Bundle> BundleQueue;
 
     // How many frames pass between each cull.
     int CullingPeriod = 4;
+    // Estimate each player's latency from round-trip time samples instead of
+    // assuming CULLING_SIMULATED_LATENCY for everyone.
+    UPROPERTY(EditAnywhere)
+    bool UseLatencyEstimator = true;
+    // Sample simulated connections instead of the engine's measured pings.
+    // Only meant for testing the estimator without real clients.
+    UPROPERTY(EditAnywhere)
+    bool SimulateLatencySamples = false;
+    // Ticks between latency samples.
+    UPROPERTY(EditAnywhere)
+    int LatencySampleInterval = SERVER_TICKRATE / 4;
+    // Percentile of recent round-trip times, plus margin in seconds,
+    // used as each player's latency.
+    UPROPERTY(EditAnywhere)
+    float LatencyPercentile = 0.95;
+    UPROPERTY(EditAnywhere)
+    float LatencyMargin = 0.01;
+    LatencyEstimator Latencies;
+    std::unique_ptr<ILatencySource> LatencySource;
+    // Give each player its own culling period, staggered across ticks,
+    // instead of culling everyone every CullingPeriod ticks. A player's
+    // peeks cover its latency plus its period, so that together they fit in
+    // PeekTimeBudget: low-latency players are culled less often, and
+    // high-latency players every tick.
+    UPROPERTY(EditAnywhere)
+    bool AdaptiveCullingPeriods = true;
+    UPROPERTY(EditAnywhere)
+    float PeekTimeBudget = 0.15;
+    UPROPERTY(EditAnywhere)
+    int MaxCullingPeriod = 8;
+    // Culling period of each player in ticks.
+    std::vector<int> CullingPeriods;
     // Stores how many ticks character j remains visible to character i for.
     int VisibilityTimers[MAX_CHARACTERS][MAX_CHARACTERS] = { 0 };
     // How many ticks an enemy stays visible for after being revealed.
@@ -79,44 +364,196 @@ class ACullingController : public AInfo
     int RollingWindowLength = SERVER_TICKRATE;
     // Total ticks since game start.
     int TotalTicks = 0;
+    // Tick that the current cull started on, and the one before it.
+    // Culls trail TotalTicks when culling asynchronously.
+    int CullTick = 0;
+    int PreviousCullTick = -1;
+    // Cull on a worker thread instead of blocking the game thread.
+    // Each cull takes the bounds at the tick it starts on, and its results
+    // are swapped in AsyncCullingDelay ticks later, which peeks cover as
+    // extra latency. Benchmarks of accelerators and kernels are skipped.
+    UPROPERTY(EditAnywhere)
+    bool UseAsyncCulling = false;
+    UPROPERTY(EditAnywhere)
+    int AsyncCullingDelay = 2;
+    std::unique_ptr<CullingWorker> Worker;
+    // Results of the last two culls. The worker writes the back buffer
+    // while the game thread reads the front one.
+    VisibilityResults Results[2];
+    std::atomic<int> FrontResults { 0 };
+    // Tick that the running asynchronous cull started on, or -1 if none.
+    int AsyncCullTick = -1;
+    // Times that the game thread waited for the worker to finish.
+    int AsyncStalls = 0;
+    // Visibility timers when the running asynchronous cull started,
+    // as the game thread keeps updating VisibilityTimers.
+    int AsyncVisibilityTimers[MAX_CHARACTERS][MAX_CHARACTERS] = { 0 };
+    // Microseconds that each cull may take, or 0 for no limit. Due pairs are
+    // culled in chunks of BudgetChunkSize in order of priority, and the
+    // pairs left when time runs out are handled by DeferredPairPolicy and
+    // culled first on the next tick.
+    UPROPERTY(EditAnywhere)
+    int CullingBudget = 0;
+    UPROPERTY(EditAnywhere)
+    int BudgetChunkSize = 32;
+    UPROPERTY(EditAnywhere)
+    EDeferredPairPolicy DeferredPairPolicy = EDeferredPairPolicy::FailOpen;
+    // Whether each pair was deferred by the last cull, and how many of each
+    // player's pairs were.
+    bool IsDeferred[MAX_CHARACTERS][MAX_CHARACTERS] = { { false } };
+    int DeferredCounts[MAX_CHARACTERS] = { 0 };
+    // Whether each pair was visible when it was last culled.
+    bool WasVisible[MAX_CHARACTERS][MAX_CHARACTERS] = { { false } };
+    // Tick that each pair was last culled on, or -1 if never.
+    int LastCulledTicks[MAX_CHARACTERS][MAX_CHARACTERS];
+    // Pairs deferred and culls that overran the budget in the rolling window.
+    // Only the game thread reads these, adding the counts of each cull
+    // once its results are in.
+    int DeferredPairs = 0;
+    int BudgetOverruns = 0;
+    // Counts of the last cull, written by whichever thread ran it.
+    int CullDeferredPairs = 0;
+    bool CullOverranBudget = false;
+    // Box of possible displacements of each player's camera,
+    // gathered on the game thread before each cull.
+    std::vector<FBox> PeekDisplacements;
     // Stores total culling time to calculate an overall average.
     int TotalTime = 0;
 
     // Cull visibility for all player, enemy pairs.
     void Cull();
+    // Gathers everything that culling reads from the game on the game thread.
+    // Returns false if no player is due to be culled.
+    bool PrepareCull();
+    // Runs the culling pipeline on the prepared state, leaving the visible
+    // bundles in BundleQueue. Safe to run off the game thread.
+    void RunCull();
+    // Swaps in the results of the asynchronous cull when they are due,
+    // and starts the next one.
+    void CullAsync();
+    // Writes the visible bundles of a finished cull to the back buffer.
+    void PublishResults();
+    // Runs the culling stages on the bundles in BundleQueue, leaving the
+    // visible ones. Benchmarks run only if RunBenchmarks is set.
+    void CullBundles(bool RunBenchmarks);
+    // Gets the visibility timer of a pair as of the start of the cull.
+    int GetCullTimer(int i, int j) const;
+    // Orders bundles from the highest culling priority to the lowest.
+    void SortByPriority(std::vector<Bundle>& Bundles) const;
     // Updates the bounding volumes of characters.
     void UpdateCharacterBounds();
     // Calculates all bundles of lines of sight between characters,
     // adding them to the BundleQueue for culling.
+    // Skips pairs in cells that cannot see each other,
+    // according to the cell-and-portal graph or the PVS.
     void PopulateBundles();
+    // Greedily clusters living characters of each team into squads.
+    void BuildSquads();
+    // Finds a cuboid that blocks every line of sight from squad a's peeks to
+    // squad b's bounding boxes, or NULL. Pairs of single characters are left
+    // to per-pair culling.
+    const Cuboid* FindSquadBlocker(int a, int b);
+    // Builds the cell-and-portal graph from the cells and portals in the map.
+    void BuildCellGraph();
     // Culls all bundles with each player's cache of occluders.
     void CullWithCache();
+    // Culls queued bundles with cuboids that recently blocked nearby pairs.
+    void CullWithHints();
     // Culls queued bundles with occluding spheres.
     void CullWithSpheres();
+    // Sphere traces queued bundles through the distance field, setting aside
+    // bundles that are proven visible and culling with nearby cuboids.
+    void CullWithDistanceField();
+    // Culls queued bundles that stay within the playable band with walls.
+    void CullWithWalls();
+    // Culls queued bundles with the shadow volumes of cuboids near each player.
+    void CullWithShadowVolumes();
     // Culls queued bundles with occluding cuboids.
     void CullWithCuboids();
+    // Checks if a bundle uses IsBlocking with four peeks and the full bounding
+    // box, which fusion assumes.
+    bool UsesDefaultTest(const Bundle& B) const;
+    // Checks if a cuboid blocks a bundle with the selected blocking test.
+    bool Blocks(const Bundle& B, const Cuboid* C) const;
+    // Times both blocking tests on the queued bundles and counts the
+    // cuboids that block by one test but not the other.
+    void CompareBlockingKernels();
+    // Finds a cuboid that blocks a bundle with the selected accelerator.
+    const Cuboid* FindBlockingCuboid(const Bundle& B, EOccluderAccelerator Structure);
+    // Logs simulated cache misses per BVH traversal before and after
+    // reordering nodes, on segments between characters and random segments.
+    void CompareNodeOrders();
+    // Times each accelerator on the queued bundles without culling them.
+    void CompareAccelerators();
+    // Culls queued bundles with a depth and ID buffer of nearby cuboids.
+    void CullWithRasterizer();
+    // Finds the bundles of the player whose bundles start at Start,
+    // the box containing all of their peeks, and the cuboids that may
+    // block them, stored in NearbyCuboids. Returns the end of the bundles.
+    int GatherNearbyCuboids(int Start, FBox& Source);
+    // Inserts a cuboid that blocked a bundle into the cache of its pair,
+    // replacing the least recently used cuboid.
+    void CacheCuboid(const Bundle& B, const Cuboid* C);
+    // Records how far a blocked bundle's pair can move while C blocks it.
+    void SetValidityHorizon(const Bundle& B, const Cuboid* C);
+    // Checks if player i's peeks and enemy j's bounding box have stayed
+    // within the validity margin since they were last blocked.
+    bool IsWithinValidityHorizon(int i, int j, const std::vector<FVector>& Peeks);
     // Gets corners of the rectangle encompassing a player's possible peeks
-    // on an enemy--in the plane normal to the line of sight.
+    // on an enemy--in the plane normal to the line of sight--given the box
+    // of displacements of the player's camera.
     // When facing along the vector from player to enemy, Corners are indexed
     // starting from the top right, proceeding counter-clockwise.
     // NOTE:
     //   Inaccurate on very wide enemies, as the most aggressive angle to peek
     //   the left of an enemy is actually perpendicular to the leftmost point
     //   of the enemy, not its center.
+    // With 2 peeks, only the vertical displacement is kept. With 8 peeks,
+    // Corners are the top then bottom corners of the box of displacements,
+    // with corner k above corner 7 - k.
     static std::vector<FVector> GetPossiblePeeks(
         const FVector& PlayerCameraLocation,
         const FVector& EnemyLocation,
-        float MaxDeltaHorizontal,
-        float MaxDeltaVertical);
+        const FBox& Displacements,
+        int NumPeeks = NUM_PEEKS);
+    // Picks the number of peeks of a player given the box of displacements
+    // of its camera.
+    int SelectNumPeeks(
+        const FVector& PlayerCameraLocation,
+        const FVector& EnemyLocation,
+        const FBox& Displacements);
     // Gets the estimated latency of player i in seconds.
     float GetLatency(int i);
+    // Samples latencies when due and updates culling periods.
+    void UpdateLatencies();
+    // Checks if player i was due to be culled on any tick since the
+    // previous cull.
+    bool IsCullingTick(int i) const;
+    // Gets how long player i's peeks must cover: its latency plus the time
+    // until it is next culled and until asynchronous results arrive.
+    float GetPeekTime(int i);
+    // Gets how many ticks an enemy stays visible to player i after being
+    // revealed.
+    int GetVisibilityTimerMax(int i) const;
+    // Gets a box containing every displacement of player i's camera before
+    // the server learns of it.
+    FBox GetPeekDisplacements(int i);
+    // Gets the center of player i's possible peeks, which lies between
+    // the peeks of every bundle of the player.
+    FVector GetPeekCenter(int i) const
+    {
+        return Bounds[i].CameraLocation + PeekDisplacements[i].GetCenter();
+    }
     // Converts culling results into changes in in-game visibility.
     void UpdateVisibility();
+    // Sends the locations of all revealed enemies and counts down their timers.
+    void RevealEnemies();
     // Sends character j's location to character i.
     void SendLocation(int i, int j);
 
 protected:
     void BeginPlay() override;
+    void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 public:
     ACullingController();
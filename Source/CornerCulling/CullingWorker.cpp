@@ -0,0 +1,71 @@
+#include "CullingWorker.h"
+
+CullingWorker::CullingWorker(TFunction<void()> NewJob)
+    : Job(MoveTemp(NewJob)), Stopping(false), Busy(false)
+{
+    if (!FPlatformProcess::SupportsMultithreading())
+    {
+        return;
+    }
+    StartEvent = FPlatformProcess::GetSynchEventFromPool();
+    DoneEvent = FPlatformProcess::GetSynchEventFromPool(true);
+    DoneEvent->Trigger();
+    Thread = FRunnableThread::Create(this, TEXT("CullingWorker"));
+}
+
+CullingWorker::~CullingWorker()
+{
+    if (Thread != nullptr)
+    {
+        // Calls Stop and waits for the current job to finish.
+        Thread->Kill(true);
+        delete Thread;
+    }
+    if (StartEvent != nullptr)
+    {
+        FPlatformProcess::ReturnSynchEventToPool(StartEvent);
+        FPlatformProcess::ReturnSynchEventToPool(DoneEvent);
+    }
+}
+
+void CullingWorker::Start()
+{
+    if (Thread == nullptr)
+    {
+        Job();
+        return;
+    }
+    Busy = true;
+    DoneEvent->Reset();
+    StartEvent->Trigger();
+}
+
+void CullingWorker::Wait()
+{
+    if (Thread != nullptr)
+    {
+        DoneEvent->Wait();
+    }
+}
+
+uint32 CullingWorker::Run()
+{
+    while (true)
+    {
+        StartEvent->Wait();
+        if (Stopping)
+        {
+            break;
+        }
+        Job();
+        Busy = false;
+        DoneEvent->Trigger();
+    }
+    return 0;
+}
+
+void CullingWorker::Stop()
+{
+    Stopping = true;
+    StartEvent->Trigger();
+}
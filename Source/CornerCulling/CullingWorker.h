@@ -0,0 +1,34 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/Event.h"
+#include <atomic>
+
+// Runs a job on a dedicated thread each time it is started, so that the
+// game thread can keep simulating while the job runs. Runs the job on the
+// calling thread instead if the platform does not support threads.
+class CullingWorker : public FRunnable
+{
+    TFunction<void()> Job;
+    FRunnableThread* Thread = nullptr;
+    // Signaled to start the job, and to wake the thread when stopping.
+    FEvent* StartEvent = nullptr;
+    // Signaled while the worker is idle.
+    FEvent* DoneEvent = nullptr;
+    std::atomic<bool> Stopping;
+    std::atomic<bool> Busy;
+
+public:
+    CullingWorker(TFunction<void()> NewJob);
+    ~CullingWorker();
+    // Starts the job. The worker must be idle.
+    void Start();
+    bool IsBusy() const { return Busy; }
+    // Blocks until the job finishes.
+    void Wait();
+
+    uint32 Run() override;
+    void Stop() override;
+};
@@ -0,0 +1,193 @@
+#include "DistanceField.h"
+#include "Async/ParallelFor.h"
+#include <numeric>
+
+// Gets a lower bound on the distance from a point to a cuboid:
+// the largest signed distance to the planes of its faces, or 0 if inside.
+static float GetLowerBound(const Cuboid& C, const FVector& Point)
+{
+    float Distance = 0;
+    for (int i = 0; i < CUBOID_F; i++)
+    {
+        Distance = std::max(Distance, C.Faces[i].Normal | (Point - C.GetVertex(i, 0)));
+    }
+    return Distance;
+}
+
+void DistanceField::Build(
+    const std::vector<Cuboid>& Cuboids,
+    float NewVoxelSize,
+    SIZE_T MaxMemoryBytes)
+{
+    BrickDistances.clear();
+    BrickVoxels.clear();
+    VoxelDistances.clear();
+    VoxelCuboids.clear();
+    if (Cuboids.size() == 0)
+    {
+        return;
+    }
+    VoxelSize = NewVoxelSize;
+    Bounds = FBox(ForceInit);
+    for (const Cuboid& C : Cuboids)
+    {
+        Bounds += FBox(C.Vertices, CUBOID_V);
+    }
+    int NumBricks;
+    // Grow voxels until the coarse grid uses at most a quarter of the budget.
+    while (true)
+    {
+        BrickWorldSize = BRICK_SIZE * VoxelSize;
+        FVector Size = Bounds.GetSize();
+        NumBricks = 1;
+        for (int k = 0; k < 3; k++)
+        {
+            Dims[k] = std::max(1, FMath::CeilToInt(Size[k] / BrickWorldSize));
+            NumBricks *= Dims[k];
+        }
+        if (NumBricks * (sizeof(float) + sizeof(int)) <= MaxMemoryBytes / 4)
+        {
+            break;
+        }
+        VoxelSize *= 2;
+    }
+    Origin = Bounds.Min;
+    float BrickRadius = BrickWorldSize * FMath::Sqrt(3.0f) / 2;
+    auto GetBrickCenter = [&](int Brick)
+    {
+        int X = Brick % Dims[0];
+        int Y = (Brick / Dims[0]) % Dims[1];
+        int Z = Brick / (Dims[0] * Dims[1]);
+        return Origin + BrickWorldSize * FVector(X + 0.5f, Y + 0.5f, Z + 0.5f);
+    };
+    // Bound the distance at the center of each brick.
+    std::vector<float> CenterDistances(NumBricks);
+    ParallelFor(NumBricks, [&](int32 Brick)
+    {
+        FVector Center = GetBrickCenter(Brick);
+        float Distance = std::numeric_limits<float>::infinity();
+        for (const Cuboid& C : Cuboids)
+        {
+            Distance = std::min(Distance, GetLowerBound(C, Center));
+        }
+        CenterDistances[Brick] = Distance;
+    });
+    BrickDistances.resize(NumBricks);
+    for (int Brick = 0; Brick < NumBricks; Brick++)
+    {
+        BrickDistances[Brick] = std::max(0.0f, CenterDistances[Brick] - BrickRadius);
+    }
+    // Allocate voxels for bricks near cuboids, nearest first.
+    // Far bricks already allow long steps.
+    BrickVoxels.assign(NumBricks, -1);
+    std::vector<int> Order(NumBricks);
+    std::iota(Order.begin(), Order.end(), 0);
+    std::sort(
+        Order.begin(),
+        Order.end(),
+        [&](int A, int B) { return CenterDistances[A] < CenterDistances[B]; });
+    SIZE_T BrickBytes = BRICK_VOXELS * (sizeof(float) + sizeof(int));
+    int NumAllocated = 0;
+    for (int Brick : Order)
+    {
+        if (CenterDistances[Brick] > BrickWorldSize + BrickRadius
+            || GetMemoryBytes() + (NumAllocated + 1) * BrickBytes > MaxMemoryBytes)
+        {
+            break;
+        }
+        BrickVoxels[Brick] = BRICK_VOXELS * NumAllocated++;
+    }
+    VoxelDistances.resize(BRICK_VOXELS * NumAllocated);
+    VoxelCuboids.resize(BRICK_VOXELS * NumAllocated);
+    ParallelFor(NumAllocated, [&](int32 k)
+    {
+        int Brick = Order[k];
+        FVector Center = GetBrickCenter(Brick);
+        // Only cuboids that are near the brick can be nearest to its voxels.
+        std::vector<int> Candidates;
+        for (int c = 0; c < Cuboids.size(); c++)
+        {
+            if (GetLowerBound(Cuboids[c], Center) <= CenterDistances[Brick] + 2 * BrickRadius)
+            {
+                Candidates.emplace_back(c);
+            }
+        }
+        FVector BrickMin = Center - FVector(BrickWorldSize / 2);
+        for (int v = 0; v < BRICK_VOXELS; v++)
+        {
+            FVector VoxelCenter = BrickMin + VoxelSize * FVector(
+                v % BRICK_SIZE + 0.5f,
+                (v / BRICK_SIZE) % BRICK_SIZE + 0.5f,
+                v / (BRICK_SIZE * BRICK_SIZE) + 0.5f);
+            float Distance = std::numeric_limits<float>::infinity();
+            int Nearest = -1;
+            for (int c : Candidates)
+            {
+                float CuboidDistance = GetLowerBound(Cuboids[c], VoxelCenter);
+                if (CuboidDistance < Distance)
+                {
+                    Distance = CuboidDistance;
+                    Nearest = c;
+                }
+            }
+            VoxelDistances[BrickVoxels[Brick] + v] = Distance;
+            VoxelCuboids[BrickVoxels[Brick] + v] = Nearest;
+        }
+    });
+}
+
+float DistanceField::GetDistance(const FVector& Point, int& NearestCuboid) const
+{
+    NearestCuboid = -1;
+    // Every cuboid is inside the bounds.
+    if (!Bounds.IsInside(Point))
+    {
+        return FMath::Sqrt(Bounds.ComputeSquaredDistanceToPoint(Point));
+    }
+    FVector Local = (Point - Origin) / BrickWorldSize;
+    int X = FMath::Clamp(FMath::FloorToInt(Local.X), 0, Dims[0] - 1);
+    int Y = FMath::Clamp(FMath::FloorToInt(Local.Y), 0, Dims[1] - 1);
+    int Z = FMath::Clamp(FMath::FloorToInt(Local.Z), 0, Dims[2] - 1);
+    int Brick = X + Dims[0] * (Y + Dims[1] * Z);
+    if (BrickVoxels[Brick] < 0)
+    {
+        return BrickDistances[Brick];
+    }
+    FVector VoxelLocal = (Point - Origin - BrickWorldSize * FVector(X, Y, Z)) / VoxelSize;
+    int VX = FMath::Clamp(FMath::FloorToInt(VoxelLocal.X), 0, BRICK_SIZE - 1);
+    int VY = FMath::Clamp(FMath::FloorToInt(VoxelLocal.Y), 0, BRICK_SIZE - 1);
+    int VZ = FMath::Clamp(FMath::FloorToInt(VoxelLocal.Z), 0, BRICK_SIZE - 1);
+    int Voxel = BrickVoxels[Brick] + VX + BRICK_SIZE * (VY + BRICK_SIZE * VZ);
+    FVector VoxelCenter = Origin
+        + BrickWorldSize * FVector(X, Y, Z)
+        + VoxelSize * FVector(VX + 0.5f, VY + 0.5f, VZ + 0.5f);
+    NearestCuboid = VoxelCuboids[Voxel];
+    return std::max(0.0f, VoxelDistances[Voxel] - FVector::Dist(Point, VoxelCenter));
+}
+
+int DistanceField::Trace(
+    const FVector& Start,
+    const FVector& End,
+    float MinStep,
+    int MaxSteps,
+    int& NearestCuboid) const
+{
+    FVector Direction = End - Start;
+    float Length = Direction.Size();
+    Direction = Direction.GetSafeNormal();
+    float Time = 0;
+    for (int Step = 0; Step < MaxSteps; Step++)
+    {
+        float Distance = GetDistance(Start + Time * Direction, NearestCuboid);
+        if (Distance < MinStep)
+        {
+            return 0;
+        }
+        Time += Distance;
+        if (Time >= Length)
+        {
+            return 1;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GeometricPrimitives.h"
+#include <vector>
+
+// Number of voxels along each side of a brick.
+constexpr int BRICK_SIZE = 8;
+constexpr int BRICK_VOXELS = BRICK_SIZE * BRICK_SIZE * BRICK_SIZE;
+
+// Sparse, precomputed field of lower bounds on the distance to the nearest
+// occluding cuboid, stored as a brick map.
+// The map is a coarse grid of bricks. Every brick stores a lower bound that
+// holds anywhere inside it, and bricks near cuboids also store a fine grid of
+// voxels, each holding the distance bound at its center and the nearest cuboid.
+// Distances are bounded with the largest signed distance to a cuboid's face
+// planes, which never exceeds the true distance. Bounds are 1-Lipschitz, so
+// subtracting the distance to a sample point keeps them valid.
+class DistanceField
+{
+    FVector Origin;
+    float VoxelSize = 0;
+    float BrickWorldSize = 0;
+    int Dims[3] = { 0, 0, 0 };
+    FBox Bounds;
+    // Lower bound on the distance from any point in each brick to a cuboid.
+    std::vector<float> BrickDistances;
+    // Index of the voxels of each brick, or -1 if the brick is coarse.
+    std::vector<int> BrickVoxels;
+    // Distance bound at the center of each voxel of the allocated bricks.
+    std::vector<float> VoxelDistances;
+    // Index of the nearest cuboid to each voxel of the allocated bricks.
+    std::vector<int> VoxelCuboids;
+
+public:
+    // Builds the field, allocating the bricks nearest to cuboids first
+    // until the memory budget is spent. Larger voxels build faster.
+    void Build(const std::vector<Cuboid>& Cuboids, float NewVoxelSize, SIZE_T MaxMemoryBytes);
+    bool IsBuilt() const
+    {
+        return BrickDistances.size() > 0;
+    }
+    // Gets a lower bound on the distance from a point to the nearest cuboid,
+    // and the index of a nearby cuboid, or -1 if unknown.
+    float GetDistance(const FVector& Point, int& NearestCuboid) const;
+    // Sphere traces the segment from Start to End.
+    // Returns 1 if the segment is clear of every cuboid, 0 if the trace
+    // gets stuck within MinStep of a cuboid, setting its index,
+    // and -1 if the trace runs out of steps.
+    int Trace(
+        const FVector& Start,
+        const FVector& End,
+        float MinStep,
+        int MaxSteps,
+        int& NearestCuboid) const;
+    SIZE_T GetMemoryBytes() const
+    {
+        return BrickDistances.size() * sizeof(float)
+            + BrickVoxels.size() * sizeof(int)
+            + VoxelDistances.size() * sizeof(float)
+            + VoxelCuboids.size() * sizeof(int);
+    }
+};
@@ -3,9 +3,11 @@
 #include "FastBVH/BVH.h"
 #include "FastBVH/BuildStrategy.h"
 #include "FastBVH/BuildStrategy1.h"
+#include "FastBVH/CompactBVH.h"
 #include "FastBVH/Config.h"
 #include "FastBVH/Intersection.h"
 #include "FastBVH/Iterable.h"
+#include "FastBVH/NodeOrder.h"
 #include "FastBVH/Ray.h"
 #include "FastBVH/Traverser.h"
 #include "FastBVH/Vector3.h"
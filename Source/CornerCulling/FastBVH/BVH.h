@@ -83,6 +83,11 @@ class BVH final {
   //! \return A read-only iterable container of nodes.
   inline auto getNodes() const noexcept { return ConstIterable<Node<Float>>(nodes.data(), nodes.size()); }
 
+  //! Replaces the nodes with the same tree in a different layout,
+  //! such as one produced by @ref reorderNodes.
+  //! \param n The new nodes, which must reference the same primitives.
+  void replaceNodes(NodeArray<Float>&& n) noexcept { nodes = std::move(n); }
+
   //! Accesses an iterable container to the primitives in the BVH.
   //! \return An iterable container of the primitive array.
   inline std::vector<const Primitive *> getPrimitives() const noexcept { return primitives; }
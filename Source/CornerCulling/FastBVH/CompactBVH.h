@@ -0,0 +1,291 @@
+#pragma once
+
+#include "FastBVH/BVH.h"
+#include "GeometricPrimitives.h"
+#include "OccluderFusion.h"
+#include "Containers/ContainerAllocationPolicies.h"
+#include <cfloat>
+#include <vector>
+
+namespace FastBVH {
+
+    //! \brief Largest quantized coordinate.
+    constexpr uint32_t COMPACT_QUANTA = 65535;
+
+    //! \brief A 32-byte BVH node, two to a cache line.
+    //! Drops the redundant extent of @ref Node and stores the node's bounds
+    //! as 16-bit fractions of its parent's dequantized bounds.
+    //! Quantized minimums are rounded down and maximums up, so the
+    //! dequantized box always contains the original box.
+    struct alignas(32) CompactNode final
+    {
+        //! The quantized minimum and maximum corners of the node's bounds.
+        uint16_t qmin[3];
+        uint16_t qmax[3];
+
+        //! The index of the first primitive.
+        uint32_t start;
+
+        //! The number of primitives in this node.
+        uint32_t primitive_count;
+
+        //! Number of elements to skip to get to a left child's sibling.
+        uint32_t right_offset;
+
+        //! Indicates if this node is a leaf node.
+        inline constexpr bool isLeaf() const noexcept { return right_offset == 0; }
+    };
+    static_assert(sizeof(CompactNode) == 32, "CompactNode must fit two to a cache line.");
+
+    //! \brief Dequantized bounds of a node.
+    struct CompactBounds final
+    {
+        float min[3];
+        float max[3];
+    };
+
+    namespace CompactImpl {
+
+        //! Gets the size of one quantum along an axis of the parent's bounds.
+        //! Rounded up slightly so that the largest quantum reaches the parent's maximum.
+        inline float quantum(const CompactBounds& parent, int k) noexcept
+        {
+            return (parent.max[k] - parent.min[k]) * (1.0f / COMPACT_QUANTA) * (1 + 4 * FLT_EPSILON);
+        }
+
+        //! Dequantizes a child's bounds relative to its parent's bounds.
+        inline CompactBounds decode(const CompactNode& node, const CompactBounds& parent) noexcept
+        {
+            CompactBounds b;
+            for (int k = 0; k < 3; k++)
+            {
+                float q = quantum(parent, k);
+                b.min[k] = parent.min[k] + node.qmin[k] * q;
+                b.max[k] = parent.min[k] + node.qmax[k] * q;
+            }
+            return b;
+        }
+
+        //! Checks for intersection between a segment and dequantized bounds.
+        inline bool intersect(const CompactBounds& b, const OptSegment& segment, float* tnear) noexcept
+        {
+            float tmin = 0;
+            float tmax = 1;
+            for (int k = 0; k < 3; k++)
+            {
+                float t1 = (b.min[k] - segment.Start[k]) * segment.Reciprocal[k];
+                float t2 = (b.max[k] - segment.Start[k]) * segment.Reciprocal[k];
+                tmin = std::max(tmin, std::min(t1, t2));
+                tmax = std::min(tmax, std::max(t1, t2));
+                if (tmin > tmax)
+                {
+                    return false;
+                }
+            }
+            *tnear = tmin;
+            return true;
+        }
+
+    }  // namespace CompactImpl
+
+    //! \brief A BVH of cuboids stored as compact nodes.
+    //! Built from a regular BVH, which it no longer needs afterwards.
+    //! Traversal has the same contract as @ref Traverser.
+    template <typename Intersector>
+    class CompactBVH final
+    {
+        //! Nodes in the same order as the source BVH, aligned to cache lines.
+        TArray<CompactNode, TAlignedHeapAllocator<64>> nodes;
+        std::vector<const Cuboid*> primitives;
+        //! Full-precision bounds that the root is quantized against.
+        CompactBounds rootParent;
+        Intersector intersector;
+        // Joint cuboids of touching occluders. Fusion is disabled if NULL.
+        const OccluderFusion* fusion;
+
+    public:
+        //! Compresses a BVH.
+        //! \param fusion_ Joint cuboids used to fuse touching occluders.
+        CompactBVH(
+            const BVH<float, Cuboid>& bvh,
+            const Intersector& intersector_,
+            const OccluderFusion* fusion_ = NULL);
+        //! Gets the size of the nodes in bytes.
+        int nodeBytes() const noexcept { return nodes.Num() * sizeof(CompactNode); }
+        // Traces single ray through the BVH, returning a cuboid that blocks
+        // LOS between peeks and the verticies of an enemy bounding box.
+        const Cuboid* traverse(
+            const OptSegment& segment,
+            const std::vector<FVector>& peeks,
+            const CharacterBounds& bounds);
+        // Traces single ray through the BVH, calling blocks(cuboid) on each
+        // cuboid that the ray intersects until it returns a non-NULL occluder.
+        template <typename BlockingTest>
+        const Cuboid* traverse(const OptSegment& segment, BlockingTest&& blocks);
+    };
+
+    template <typename Intersector>
+    CompactBVH<Intersector>::CompactBVH(
+        const BVH<float, Cuboid>& bvh,
+        const Intersector& intersector_,
+        const OccluderFusion* fusion_)
+        : primitives(bvh.getPrimitives()), intersector(intersector_), fusion(fusion_)
+    {
+        const auto source = bvh.getNodes();
+        nodes.SetNumZeroed(source.size());
+        if (source.size() == 0)
+        {
+            return;
+        }
+        // Pad the root's parent so that rounding cannot clip the root.
+        const BBox<float>& root = source[0].bbox;
+        const float rootMin[3] = { root.min.x, root.min.y, root.min.z };
+        const float rootMax[3] = { root.max.x, root.max.y, root.max.z };
+        for (int k = 0; k < 3; k++)
+        {
+            float pad = 1e-3f * (rootMax[k] - rootMin[k]) + 1e-3f;
+            rootParent.min[k] = rootMin[k] - pad;
+            rootParent.max[k] = rootMax[k] + pad;
+        }
+        // Quantize nodes in pre-order, against their parents' decoded bounds.
+        std::vector<std::pair<uint32_t, CompactBounds>> todo;
+        todo.emplace_back(0, rootParent);
+        while (!todo.empty())
+        {
+            uint32_t ni = todo.back().first;
+            CompactBounds parent = todo.back().second;
+            todo.pop_back();
+            const Node<float>& node = source[ni];
+            CompactNode& compact = nodes[ni];
+            const float childMin[3] = { node.bbox.min.x, node.bbox.min.y, node.bbox.min.z };
+            const float childMax[3] = { node.bbox.max.x, node.bbox.max.y, node.bbox.max.z };
+            for (int k = 0; k < 3; k++)
+            {
+                float q = CompactImpl::quantum(parent, k);
+                int64 lo = 0;
+                int64 hi = COMPACT_QUANTA;
+                if (q > 0)
+                {
+                    lo = FMath::Clamp<int64>(FMath::FloorToInt((childMin[k] - parent.min[k]) / q), 0, COMPACT_QUANTA);
+                    hi = FMath::Clamp<int64>(FMath::CeilToInt((childMax[k] - parent.min[k]) / q), 0, COMPACT_QUANTA);
+                }
+                // Correct for rounding in the same arithmetic as decoding.
+                while (lo > 0 && parent.min[k] + lo * q > childMin[k])
+                {
+                    lo--;
+                }
+                while (hi < COMPACT_QUANTA && parent.min[k] + hi * q < childMax[k])
+                {
+                    hi++;
+                }
+                compact.qmin[k] = uint16_t(lo);
+                compact.qmax[k] = uint16_t(hi);
+            }
+            compact.start = node.start;
+            compact.primitive_count = node.primitive_count;
+            compact.right_offset = node.right_offset;
+            if (!node.isLeaf())
+            {
+                CompactBounds decoded = CompactImpl::decode(compact, parent);
+                todo.emplace_back(ni + node.right_offset, decoded);
+                todo.emplace_back(ni + 1, decoded);
+            }
+        }
+    }
+
+    template <typename Intersector>
+    const Cuboid*
+    CompactBVH<Intersector>::traverse(
+        const OptSegment& segment,
+        const std::vector<FVector>& peeks,
+        const CharacterBounds& bounds)
+    {
+        return traverse(
+            segment,
+            [&](const Cuboid* c) -> const Cuboid*
+            {
+                if (fusion == NULL)
+                {
+                    return IsBlocking(peeks, bounds, c) ? c : NULL;
+                }
+                return fusion->FindBlocker(c, peeks, bounds);
+            });
+    }
+
+    template <typename Intersector>
+    template <typename BlockingTest>
+    const Cuboid*
+    CompactBVH<Intersector>::traverse(
+        const OptSegment& segment,
+        BlockingTest&& blocks)
+    {
+        if (nodes.Num() == 0)
+        {
+            return NULL;
+        }
+        // Each entry holds a node and its dequantized bounds, which its
+        // children are decoded against.
+        struct Traversal
+        {
+            uint32_t i;
+            CompactBounds bounds;
+        };
+        Traversal todo[64];
+        int32_t stackptr = 0;
+        todo[0].i = 0;
+        todo[0].bounds = CompactImpl::decode(nodes[0], rootParent);
+        float tnear;
+        if (!CompactImpl::intersect(todo[0].bounds, segment, &tnear))
+        {
+            return NULL;
+        }
+        while (stackptr >= 0)
+        {
+            const Traversal current = todo[stackptr--];
+            const CompactNode& node = nodes[current.i];
+            if (node.isLeaf())
+            {
+                for (uint32_t o = 0; o < node.primitive_count; ++o)
+                {
+                    const Cuboid* obj = primitives[node.start + o];
+                    Intersection<float> hit = intersector(*obj, segment);
+                    if (hit)
+                    {
+                        const Cuboid* blocker = blocks(hit.IntersectedP);
+                        if (blocker != NULL)
+                        {
+                            return blocker;
+                        }
+                    }
+                }
+                continue;
+            }
+            uint32_t left = current.i + 1;
+            uint32_t right = current.i + node.right_offset;
+            CompactBounds leftBounds = CompactImpl::decode(nodes[left], current.bounds);
+            CompactBounds rightBounds = CompactImpl::decode(nodes[right], current.bounds);
+            float tleft, tright;
+            bool hitLeft = CompactImpl::intersect(leftBounds, segment, &tleft);
+            bool hitRight = CompactImpl::intersect(rightBounds, segment, &tright);
+            // Push the farther child first, so that the closer is visited first.
+            if (hitLeft && hitRight && tright < tleft)
+            {
+                todo[++stackptr] = { left, leftBounds };
+                todo[++stackptr] = { right, rightBounds };
+            }
+            else
+            {
+                if (hitRight)
+                {
+                    todo[++stackptr] = { right, rightBounds };
+                }
+                if (hitLeft)
+                {
+                    todo[++stackptr] = { left, leftBounds };
+                }
+            }
+        }
+        return NULL;
+    }
+
+}  // namespace FastBVH
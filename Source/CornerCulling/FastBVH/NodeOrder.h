@@ -0,0 +1,167 @@
+#pragma once
+
+#include "FastBVH/BVH.h"
+#include "GeometricPrimitives.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace FastBVH {
+
+    //! \brief Reorders BVH nodes so that traversals touch fewer cache lines.
+    //! Traversal finds a node's first child right after it and its second
+    //! child at right_offset, so any valid layout is a pre-order of the tree.
+    //! The only freedom is which child comes first. This places the child with
+    //! the larger surface area, which rays are more likely to enter, right
+    //! after its parent, so the likeliest paths through the tree are laid out
+    //! sequentially. Traversal tests both children either way, so results
+    //! are unchanged. Primitive indices are unchanged too.
+    //! \param nodes The nodes in a valid pre-order.
+    //! \return The reordered nodes.
+    template <typename Float>
+    NodeArray<Float> reorderNodes(const ConstIterable<Node<Float>>& nodes)
+    {
+        NodeArray<Float> result;
+        result.reserve(nodes.size());
+        if (nodes.size() == 0)
+        {
+            return result;
+        }
+        // Each entry is a source node and, if it is a second child,
+        // the index of its parent in the result.
+        std::vector<std::pair<uint32_t, int64_t>> todo;
+        todo.emplace_back(0, -1);
+        while (!todo.empty())
+        {
+            uint32_t src = todo.back().first;
+            int64_t parent = todo.back().second;
+            todo.pop_back();
+            uint32_t dst = result.size();
+            if (parent >= 0)
+            {
+                result[parent].right_offset = dst - uint32_t(parent);
+            }
+            result.push_back(nodes[src]);
+            const Node<Float>& node = nodes[src];
+            if (!node.isLeaf())
+            {
+                uint32_t first = src + 1;
+                uint32_t second = src + node.right_offset;
+                if (nodes[second].bbox.surfaceArea() > nodes[first].bbox.surfaceArea())
+                {
+                    std::swap(first, second);
+                }
+                todo.emplace_back(second, dst);
+                todo.emplace_back(first, -1);
+            }
+        }
+        return result;
+    }
+
+    //! \brief Records the nodes that a traversal reads, in order, without
+    //! stopping at the first blocking cuboid. Mirrors @ref Traverser.
+    //! \param nodes The nodes of a BVH.
+    //! \param segment The segment being traced.
+    //! \param trace Receives the index of each node read.
+    template <typename Float>
+    void traceNodes(
+        const ConstIterable<Node<Float>>& nodes,
+        const OptSegment& segment,
+        std::vector<uint32_t>& trace)
+    {
+        uint32_t todo[64];
+        int32_t stackptr = 0;
+        todo[stackptr] = 0;
+        Float bbhits[4];
+        while (stackptr >= 0)
+        {
+            uint32_t ni = todo[stackptr--];
+            trace.push_back(ni);
+            const auto& node(nodes[ni]);
+            if (node.isLeaf())
+            {
+                continue;
+            }
+            uint32_t left = ni + 1;
+            uint32_t right = ni + node.right_offset;
+            trace.push_back(left);
+            trace.push_back(right);
+            bool hitc0 = nodes[left].bbox.intersect(segment, bbhits, bbhits + 1);
+            bool hitc1 = nodes[right].bbox.intersect(segment, bbhits + 2, bbhits + 3);
+            if (hitc0 && hitc1)
+            {
+                // Visit the closer child first.
+                if (bbhits[2] < bbhits[0])
+                {
+                    std::swap(left, right);
+                }
+                todo[++stackptr] = right;
+                todo[++stackptr] = left;
+            }
+            else if (hitc0)
+            {
+                todo[++stackptr] = left;
+            }
+            else if (hitc1)
+            {
+                todo[++stackptr] = right;
+            }
+        }
+    }
+
+    //! \brief Simulates a set-associative cache with least-recently-used
+    //! eviction, to count the cache misses of a sequence of reads.
+    class CacheSimulator final
+    {
+        static constexpr uint32_t lineBytes = 64;
+        static constexpr uint32_t ways = 8;
+        uint32_t sets;
+        //! Line tag and last use of each way of each set.
+        std::vector<uint64_t> tags;
+        std::vector<uint64_t> lastUse;
+        uint64_t time = 0;
+
+    public:
+        uint64_t misses = 0;
+        uint64_t reads = 0;
+
+        //! \param cacheBytes The capacity of the cache.
+        explicit CacheSimulator(uint32_t cacheBytes)
+            : sets(std::max<uint32_t>(1, cacheBytes / (lineBytes * ways))),
+              tags(sets * ways, UINT64_MAX),
+              lastUse(sets * ways, 0) {}
+
+        //! Reads the bytes from address to address + size.
+        void read(uint64_t address, uint32_t size) noexcept
+        {
+            for (uint64_t line = address / lineBytes; line <= (address + size - 1) / lineBytes; line++)
+            {
+                reads++;
+                time++;
+                uint64_t* setTags = &tags[(line % sets) * ways];
+                uint64_t* setUse = &lastUse[(line % sets) * ways];
+                uint32_t victim = 0;
+                bool hit = false;
+                for (uint32_t w = 0; w < ways && !hit; w++)
+                {
+                    if (setTags[w] == line)
+                    {
+                        setUse[w] = time;
+                        hit = true;
+                    }
+                    else if (setUse[w] < setUse[victim])
+                    {
+                        victim = w;
+                    }
+                }
+                if (!hit)
+                {
+                    misses++;
+                    setTags[victim] = line;
+                    setUse[victim] = time;
+                }
+            }
+        }
+    };
+
+}  // namespace FastBVH
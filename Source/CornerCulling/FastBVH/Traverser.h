@@ -2,6 +2,7 @@
 
 #include "FastBVH/BVH.h"
 #include "GeometricPrimitives.h"
+#include "OccluderFusion.h"
 #include <vector>
 
 namespace FastBVH {
@@ -16,19 +17,35 @@ namespace FastBVH {
     {
         const BVH<Float, Cuboid>& bvh;
         Intersector intersector;
+        // Joint cuboids of touching occluders. Fusion is disabled if NULL.
+        const OccluderFusion* fusion;
 
     public:
         //! Constructs a new BVH traverser.
         //! \param bvh_ The BVH to be traversed.
-        constexpr Traverser(const BVH<Float, Cuboid>& bvh_, const Intersector& intersector_) noexcept
-            : bvh(bvh_), intersector(intersector_) {}
+        //! \param fusion_ Joint cuboids used to fuse touching occluders.
+        constexpr Traverser(
+            const BVH<Float, Cuboid>& bvh_,
+            const Intersector& intersector_,
+            const OccluderFusion* fusion_ = NULL) noexcept
+            : bvh(bvh_), intersector(intersector_), fusion(fusion_) {}
         // Traces single ray through the BVH, returning true if that ray
         // intersects a cuboid that blocks LOS between peeks and the verticies
         // of an enemy bounding box.
+        // With fusion enabled, tracks which lines of sight each visited cuboid
+        // blocks, and may return the joint cuboid of two touching cuboids.
         const Cuboid* traverse(
             const OptSegment& segment,
             const std::vector<FVector>& peeks,
             const CharacterBounds& Bounds);
+        // Traces single ray through the BVH, calling blocks(cuboid) on each
+        // cuboid that the ray intersects until it returns a non-NULL
+        // occluder, which is then returned.
+        // Lets other culling tasks reuse the traversal with their own test.
+        template <typename BlockingTest>
+        const Cuboid* traverse(const OptSegment& segment, BlockingTest&& blocks);
+        // Appends every cuboid whose bounding box overlaps the region.
+        void gather(const BBox<Float>& region, std::vector<const Cuboid*>& cuboids) const;
     };
 
     //! \brief Contains implementation details for the @ref Traverser class.
@@ -63,6 +80,28 @@ namespace FastBVH {
         const OptSegment& segment,
         const std::vector<FVector>& peeks,
         const CharacterBounds& bounds)
+    {
+        return traverse(
+            segment,
+            [&](const Cuboid* c) -> const Cuboid*
+            {
+                if (fusion == NULL)
+                {
+                    return IsBlocking(peeks, bounds, c) ? c : NULL;
+                }
+                return fusion->FindBlocker(c, peeks, bounds);
+            });
+    }
+
+    template <
+        typename Float,
+        typename Intersector
+    >
+    template <typename BlockingTest>
+    const Cuboid*
+    Traverser<Float, Intersector>::traverse(
+        const OptSegment& segment,
+        BlockingTest&& blocks)
     {
     using Traversal = TraverserImpl::Traversal<Float>;
 
@@ -100,13 +139,10 @@ namespace FastBVH {
                 Intersection<float> current = intersector(*obj, segment);
                 if (current)
                 {
-                    if (
-                        IsBlocking(
-                            peeks,
-                            bounds,
-                            current.IntersectedP))
+                    const Cuboid* blocker = blocks(current.IntersectedP);
+                    if (blocker != NULL)
                     {
-                        return current.IntersectedP;
+                        return blocker;
                     }
                 }
             }
@@ -155,4 +191,44 @@ namespace FastBVH {
     }
     return NULL;
     }
+
+    template <
+        typename Float,
+        typename Intersector
+    >
+    void
+    Traverser<Float, Intersector>::gather(
+        const BBox<Float>& region,
+        std::vector<const Cuboid*>& cuboids) const
+    {
+        uint32_t todo[64];
+        int32_t stackptr = 0;
+        todo[stackptr] = 0;
+        const auto nodes = bvh.getNodes();
+        auto build_prims = bvh.getPrimitives();
+        while (stackptr >= 0)
+        {
+            uint32_t ni = todo[stackptr--];
+            const auto& node(nodes[ni]);
+            const BBox<Float>& b = node.bbox;
+            if (b.min.x > region.max.x || b.max.x < region.min.x
+                || b.min.y > region.max.y || b.max.y < region.min.y
+                || b.min.z > region.max.z || b.max.z < region.min.z)
+            {
+                continue;
+            }
+            if (node.isLeaf())
+            {
+                for (uint32_t o = 0; o < node.primitive_count; ++o)
+                {
+                    cuboids.emplace_back(build_prims[node.start + o]);
+                }
+            }
+            else
+            {
+                todo[++stackptr] = ni + node.right_offset;
+                todo[++stackptr] = ni + 1;
+            }
+        }
+    }
 }  // namespace FastBVH
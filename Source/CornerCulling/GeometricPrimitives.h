@@ -128,6 +128,11 @@ struct Bundle
 	unsigned char PlayerI;
 	unsigned char EnemyI;
     std::vector<FVector> PossiblePeeks;
+    // Distant enemies are replaced by a billboard, a rectangle that every
+    // line of sight to their bounding box passes through.
+    // Stores its two top corners, then the two bottom corners below them.
+    bool HasBillboard = false;
+    FVector BillboardVertices[4];
 	Bundle(int i, int j, const std::vector<FVector>& Peeks)
     {
 		PlayerI = i;
@@ -143,6 +148,8 @@ struct CharacterBounds
 {
     // Location of character's camera.
     FVector CameraLocation;
+    // Velocity of the character when its bounds were taken.
+    FVector Velocity = FVector::ZeroVector;
     // Center of character and bounding spheres.
     FVector Center;
     float BoundingSphereRadius = 105;
@@ -150,8 +157,8 @@ struct CharacterBounds
     // a player peeks it from above, and vice versa for peeks from below.
     // This computational shortcut assumes that each bottom vertex is
     // directly below a corresponding top vertex.
-    std::vector<FVector> TopVertices;
-    std::vector<FVector> BottomVertices;
+    FVector TopVertices[4];
+    FVector BottomVertices[4];
     // We also precalculate and store representations optimized for SIMD.
     __m256 TopVerticesXs;
     __m256 TopVerticesYs;
@@ -159,18 +166,46 @@ struct CharacterBounds
     __m256 BottomVerticesXs;
     __m256 BottomVerticesYs;
     __m256 BottomVerticesZs;
+    // Empty bounds, to be set in place later.
+    CharacterBounds() {}
     CharacterBounds(FVector CameraLocation, FTransform T)
     {
-        this->CameraLocation = CameraLocation;
+        Set(CameraLocation, T);
+    }
+    // Overwrites the bounds in place.
+    void Set(FVector NewCameraLocation, FTransform T)
+    {
+        CameraLocation = NewCameraLocation;
         Center = T.GetTranslation();
-        TopVertices.emplace_back(T.TransformPositionNoScale(FVector(30, 15, 100)));
-        TopVertices.emplace_back(T.TransformPositionNoScale(FVector(30, -15, 100)));
-        TopVertices.emplace_back(T.TransformPositionNoScale(FVector(-30, 15, 100)));
-        TopVertices.emplace_back(T.TransformPositionNoScale(FVector(-30, -15, 100)));
-        BottomVertices.emplace_back(T.TransformPositionNoScale(FVector(30, 15, -100)));
-        BottomVertices.emplace_back(T.TransformPositionNoScale(FVector(30, -15, -100)));
-        BottomVertices.emplace_back(T.TransformPositionNoScale(FVector(-30, 15, -100)));
-        BottomVertices.emplace_back(T.TransformPositionNoScale(FVector(-30, -15, -100)));
+        TopVertices[0] = T.TransformPositionNoScale(FVector(30, 15, 100));
+        TopVertices[1] = T.TransformPositionNoScale(FVector(30, -15, 100));
+        TopVertices[2] = T.TransformPositionNoScale(FVector(-30, 15, 100));
+        TopVertices[3] = T.TransformPositionNoScale(FVector(-30, -15, 100));
+        BottomVertices[0] = T.TransformPositionNoScale(FVector(30, 15, -100));
+        BottomVertices[1] = T.TransformPositionNoScale(FVector(30, -15, -100));
+        BottomVertices[2] = T.TransformPositionNoScale(FVector(-30, 15, -100));
+        BottomVertices[3] = T.TransformPositionNoScale(FVector(-30, -15, -100));
+        PackVertices();
+    }
+    // Bounds of an axis-aligned box, such as the union of the bounding boxes
+    // of several characters.
+    CharacterBounds(const FBox& Box)
+    {
+        Center = Box.GetCenter();
+        CameraLocation = Center;
+        BoundingSphereRadius = Box.GetExtent().Size();
+        const float Xs[4] = { Box.Max.X, Box.Max.X, Box.Min.X, Box.Min.X };
+        const float Ys[4] = { Box.Max.Y, Box.Min.Y, Box.Max.Y, Box.Min.Y };
+        for (int k = 0; k < 4; k++)
+        {
+            TopVertices[k] = FVector(Xs[k], Ys[k], Box.Max.Z);
+            BottomVertices[k] = FVector(Xs[k], Ys[k], Box.Min.Z);
+        }
+        PackVertices();
+    }
+    // Stores the vertices in the representations optimized for SIMD.
+    void PackVertices()
+    {
         TopVerticesXs = _mm256_set_ps(
             TopVertices[0].X, TopVertices[1].X, TopVertices[2].X, TopVertices[3].X, 
             TopVertices[0].X, TopVertices[1].X, TopVertices[2].X, TopVertices[3].X);
@@ -192,6 +227,150 @@ struct CharacterBounds
     }
 };
 
+// Transposes an 8x8 matrix of floats stored as eight rows.
+inline void Transpose8x8(__m256 Rows[8])
+{
+    __m256 T0 = _mm256_unpacklo_ps(Rows[0], Rows[1]);
+    __m256 T1 = _mm256_unpackhi_ps(Rows[0], Rows[1]);
+    __m256 T2 = _mm256_unpacklo_ps(Rows[2], Rows[3]);
+    __m256 T3 = _mm256_unpackhi_ps(Rows[2], Rows[3]);
+    __m256 T4 = _mm256_unpacklo_ps(Rows[4], Rows[5]);
+    __m256 T5 = _mm256_unpackhi_ps(Rows[4], Rows[5]);
+    __m256 T6 = _mm256_unpacklo_ps(Rows[6], Rows[7]);
+    __m256 T7 = _mm256_unpackhi_ps(Rows[6], Rows[7]);
+    __m256 S0 = _mm256_shuffle_ps(T0, T2, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 S1 = _mm256_shuffle_ps(T0, T2, _MM_SHUFFLE(3, 2, 3, 2));
+    __m256 S2 = _mm256_shuffle_ps(T1, T3, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 S3 = _mm256_shuffle_ps(T1, T3, _MM_SHUFFLE(3, 2, 3, 2));
+    __m256 S4 = _mm256_shuffle_ps(T4, T6, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 S5 = _mm256_shuffle_ps(T4, T6, _MM_SHUFFLE(3, 2, 3, 2));
+    __m256 S6 = _mm256_shuffle_ps(T5, T7, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 S7 = _mm256_shuffle_ps(T5, T7, _MM_SHUFFLE(3, 2, 3, 2));
+    Rows[0] = _mm256_permute2f128_ps(S0, S4, 0x20);
+    Rows[1] = _mm256_permute2f128_ps(S1, S5, 0x20);
+    Rows[2] = _mm256_permute2f128_ps(S2, S6, 0x20);
+    Rows[3] = _mm256_permute2f128_ps(S3, S7, 0x20);
+    Rows[4] = _mm256_permute2f128_ps(S0, S4, 0x31);
+    Rows[5] = _mm256_permute2f128_ps(S1, S5, 0x31);
+    Rows[6] = _mm256_permute2f128_ps(S2, S6, 0x31);
+    Rows[7] = _mm256_permute2f128_ps(S3, S7, 0x31);
+}
+
+// Sets the bounds of Count characters from their camera locations and
+// transforms, matching the CharacterBounds constructor, but transforming
+// the corners of 8 characters at once and writing the SIMD representations
+// directly. Out[k] receives the bounds of character k.
+inline void BuildCharacterBounds(
+    int Count,
+    const FVector* CameraLocations,
+    const FTransform* Transforms,
+    CharacterBounds* const* Out)
+{
+    // Local corners of the box, top then bottom, in the vertex order
+    // of CharacterBounds.
+    static const float CornerXs[8] = { 30, 30, -30, -30, 30, 30, -30, -30 };
+    static const float CornerYs[8] = { 15, -15, 15, -15, 15, -15, 15, -15 };
+    static const float CornerZs[8] = { 100, 100, 100, 100, -100, -100, -100, -100 };
+    const __m256 Ones = _mm256_set1_ps(1);
+    const __m256 Twos = _mm256_set1_ps(2);
+    for (int First = 0; First < Count; First += 8)
+    {
+        int BatchSize = std::min(8, Count - First);
+        // Gather rotations and translations into SoA arrays, repeating
+        // the last character to fill the batch.
+        alignas(32) float Q[4][8];
+        alignas(32) float Translations[3][8];
+        for (int k = 0; k < 8; k++)
+        {
+            const FTransform& T = Transforms[First + std::min(k, BatchSize - 1)];
+            const FQuat Rotation = T.GetRotation();
+            const FVector Translation = T.GetTranslation();
+            Q[0][k] = Rotation.X;
+            Q[1][k] = Rotation.Y;
+            Q[2][k] = Rotation.Z;
+            Q[3][k] = Rotation.W;
+            Translations[0][k] = Translation.X;
+            Translations[1][k] = Translation.Y;
+            Translations[2][k] = Translation.Z;
+        }
+        __m256 X = _mm256_load_ps(Q[0]);
+        __m256 Y = _mm256_load_ps(Q[1]);
+        __m256 Z = _mm256_load_ps(Q[2]);
+        __m256 W = _mm256_load_ps(Q[3]);
+        __m256 Tx = _mm256_load_ps(Translations[0]);
+        __m256 Ty = _mm256_load_ps(Translations[1]);
+        __m256 Tz = _mm256_load_ps(Translations[2]);
+        // Rotation matrix of each unit quaternion.
+        __m256 XX = _mm256_mul_ps(X, X);
+        __m256 YY = _mm256_mul_ps(Y, Y);
+        __m256 ZZ = _mm256_mul_ps(Z, Z);
+        __m256 XY = _mm256_mul_ps(X, Y);
+        __m256 XZ = _mm256_mul_ps(X, Z);
+        __m256 YZ = _mm256_mul_ps(Y, Z);
+        __m256 WX = _mm256_mul_ps(W, X);
+        __m256 WY = _mm256_mul_ps(W, Y);
+        __m256 WZ = _mm256_mul_ps(W, Z);
+        __m256 R[3][3];
+        R[0][0] = _mm256_sub_ps(Ones, _mm256_mul_ps(Twos, _mm256_add_ps(YY, ZZ)));
+        R[0][1] = _mm256_mul_ps(Twos, _mm256_sub_ps(XY, WZ));
+        R[0][2] = _mm256_mul_ps(Twos, _mm256_add_ps(XZ, WY));
+        R[1][0] = _mm256_mul_ps(Twos, _mm256_add_ps(XY, WZ));
+        R[1][1] = _mm256_sub_ps(Ones, _mm256_mul_ps(Twos, _mm256_add_ps(XX, ZZ)));
+        R[1][2] = _mm256_mul_ps(Twos, _mm256_sub_ps(YZ, WX));
+        R[2][0] = _mm256_mul_ps(Twos, _mm256_sub_ps(XZ, WY));
+        R[2][1] = _mm256_mul_ps(Twos, _mm256_add_ps(YZ, WX));
+        R[2][2] = _mm256_sub_ps(Ones, _mm256_mul_ps(Twos, _mm256_add_ps(XX, YY)));
+        const __m256 Translation[3] = { Tx, Ty, Tz };
+        // Corners[Axis][Row] holds one corner of every character in the batch.
+        // Rows reverse the corners of each half, so that after transposing,
+        // each character's row matches the lane order of _mm256_set_ps.
+        __m256 Corners[3][8];
+        for (int c = 0; c < 8; c++)
+        {
+            int Row = (c < 4) ? 3 - c : 11 - c;
+            __m256 A = _mm256_set1_ps(CornerXs[c]);
+            __m256 B = _mm256_set1_ps(CornerYs[c]);
+            __m256 C = _mm256_set1_ps(CornerZs[c]);
+            for (int Axis = 0; Axis < 3; Axis++)
+            {
+                Corners[Axis][Row] = _mm256_add_ps(
+                    Translation[Axis],
+                    _mm256_add_ps(
+                        _mm256_mul_ps(A, R[Axis][0]),
+                        _mm256_add_ps(_mm256_mul_ps(B, R[Axis][1]), _mm256_mul_ps(C, R[Axis][2]))));
+            }
+        }
+        for (int Axis = 0; Axis < 3; Axis++)
+        {
+            Transpose8x8(Corners[Axis]);
+        }
+        for (int k = 0; k < BatchSize; k++)
+        {
+            CharacterBounds& Bounds = *Out[First + k];
+            Bounds.CameraLocation = CameraLocations[First + k];
+            Bounds.Center = Transforms[First + k].GetTranslation();
+            // The low half of each row holds the top vertices,
+            // and the high half holds the bottom vertices.
+            Bounds.TopVerticesXs = _mm256_permute2f128_ps(Corners[0][k], Corners[0][k], 0x00);
+            Bounds.TopVerticesYs = _mm256_permute2f128_ps(Corners[1][k], Corners[1][k], 0x00);
+            Bounds.TopVerticesZs = _mm256_permute2f128_ps(Corners[2][k], Corners[2][k], 0x00);
+            Bounds.BottomVerticesXs = _mm256_permute2f128_ps(Corners[0][k], Corners[0][k], 0x11);
+            Bounds.BottomVerticesYs = _mm256_permute2f128_ps(Corners[1][k], Corners[1][k], 0x11);
+            Bounds.BottomVerticesZs = _mm256_permute2f128_ps(Corners[2][k], Corners[2][k], 0x11);
+            alignas(32) float Lanes[3][8];
+            for (int Axis = 0; Axis < 3; Axis++)
+            {
+                _mm256_store_ps(Lanes[Axis], Corners[Axis][k]);
+            }
+            for (int v = 0; v < 4; v++)
+            {
+                Bounds.TopVertices[v] = FVector(Lanes[0][3 - v], Lanes[1][3 - v], Lanes[2][3 - v]);
+                Bounds.BottomVertices[v] = FVector(Lanes[0][7 - v], Lanes[1][7 - v], Lanes[2][7 - v]);
+            }
+        }
+    }
+}
+
 // Checks if a Cuboid intersects a line segment between Start and
 // Start + Direction * MaxTime.
 // If there is an intersection, returns the time of the point of intersection,
@@ -316,6 +495,157 @@ inline bool IntersectsAll(
     return true;
 }
 
+// Checks which line segments between Starts[i] and Ends[i] intersect a Cuboid.
+// Returns a bitmask with bit i set if and only if segment i intersects.
+// Same algorithm as IntersectsAll, but keeps going while any segment remains.
+inline int IntersectionMask(
+    const Cuboid* C,
+    __m256 StartXs,
+    __m256 StartYs,
+    __m256 StartZs,
+    __m256 EndXs,
+    __m256 EndYs,
+    __m256 EndZs)
+{
+    const __m256 Zero = _mm256_set1_ps(0);
+    __m256 EnterTimes = Zero;
+    __m256 ExitTimes = _mm256_set1_ps(1);
+    // Lanes whose segments are known to miss the cuboid.
+    __m256 Missed = _mm256_setzero_ps();
+    for (int i = 0; i < CUBOID_F; i++)
+    {
+        const FVector& Normal = C->Faces[i].Normal;
+        __m256 NormalXs = _mm256_set1_ps(Normal.X);
+        __m256 NormalYs = _mm256_set1_ps(Normal.Y);
+        __m256 NormalZs = _mm256_set1_ps(Normal.Z);
+        const FVector& Vertex = C->GetVertex(i, 0);
+        __m256 Nums =
+            _mm256_fmadd_ps(
+                _mm256_sub_ps(_mm256_set1_ps(Vertex.X), StartXs),
+                NormalXs,
+                _mm256_fmadd_ps(
+                    _mm256_sub_ps(_mm256_set1_ps(Vertex.Y), StartYs),
+                    NormalYs,
+                    _mm256_mul_ps(
+                        _mm256_sub_ps(_mm256_set1_ps(Vertex.Z), StartZs),
+                        NormalZs)));
+        __m256 Denoms =
+            _mm256_fmadd_ps(
+                _mm256_sub_ps(EndXs, StartXs),
+                NormalXs,
+                _mm256_fmadd_ps(
+                    _mm256_sub_ps(EndYs, StartYs),
+                    NormalYs,
+                    _mm256_mul_ps(_mm256_sub_ps(EndZs, StartZs), NormalZs)));
+        // Line segments parallel to and outside of a face.
+        Missed = _mm256_or_ps(
+            Missed,
+            _mm256_and_ps(
+                _mm256_cmp_ps(Denoms, Zero, _CMP_EQ_OQ),
+                _mm256_cmp_ps(Nums, Zero, _CMP_LE_OQ)));
+        __m256 Times = _mm256_div_ps(Nums, Denoms);
+        __m256 PositiveMask = _mm256_cmp_ps(Denoms, Zero, _CMP_GT_OS);
+        __m256 NegativeMask = _mm256_cmp_ps(Denoms, Zero, _CMP_LT_OS);
+        EnterTimes = _mm256_blendv_ps(
+            EnterTimes,
+            _mm256_max_ps(EnterTimes, Times),
+            NegativeMask);
+        ExitTimes = _mm256_blendv_ps(
+            ExitTimes,
+            _mm256_min_ps(ExitTimes, Times),
+            PositiveMask);
+        Missed = _mm256_or_ps(
+            Missed,
+            _mm256_cmp_ps(EnterTimes, ExitTimes, _CMP_GT_OS));
+        if (_mm256_movemask_ps(Missed) == 0xFF)
+        {
+            return 0;
+        }
+    }
+    return ~_mm256_movemask_ps(Missed) & 0xFF;
+}
+
+// Checks if the Cuboid blocks every line of sight from the top half of
+// NumPeeks peeks to the top half of NumVertices vertices, and from the bottom
+// half of the peeks to the bottom half of the vertices.
+// Segments are packed into as few 8-lane passes as the counts allow, with
+// leftover lanes repeating earlier segments. Loop bounds are compile-time
+// constants, so each instantiation unrolls into a fixed kernel.
+template <int NumPeeks, int NumVertices>
+inline bool IsBlocking(
+    const FVector* Peeks,
+    const FVector* TopVertices,
+    const FVector* BottomVertices,
+    const Cuboid* C)
+{
+    static_assert(NumPeeks % 2 == 0 && NumVertices % 2 == 0, "Peeks and vertices come in top and bottom halves.");
+    constexpr int HalfPeeks = NumPeeks / 2;
+    constexpr int HalfVertices = NumVertices / 2;
+    constexpr int NumSegments = NumPeeks * HalfVertices;
+    constexpr int NumLanes = ((NumSegments + 7) / 8) * 8;
+    alignas(32) float Lanes[6][NumLanes];
+    for (int l = 0; l < NumLanes; l++)
+    {
+        int Segment = l % NumSegments;
+        int Peek = Segment / HalfVertices;
+        int Vertex = Segment % HalfVertices;
+        const FVector& Start = Peeks[Peek];
+        const FVector& End = (Peek < HalfPeeks) ? TopVertices[Vertex] : BottomVertices[Vertex];
+        Lanes[0][l] = Start.X;
+        Lanes[1][l] = Start.Y;
+        Lanes[2][l] = Start.Z;
+        Lanes[3][l] = End.X;
+        Lanes[4][l] = End.Y;
+        Lanes[5][l] = End.Z;
+    }
+    for (int l = 0; l < NumLanes; l += 8)
+    {
+        if (
+            !IntersectsAll(
+                C,
+                _mm256_load_ps(&Lanes[0][l]),
+                _mm256_load_ps(&Lanes[1][l]),
+                _mm256_load_ps(&Lanes[2][l]),
+                _mm256_load_ps(&Lanes[3][l]),
+                _mm256_load_ps(&Lanes[4][l]),
+                _mm256_load_ps(&Lanes[5][l])))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Selects the blocking kernel for the number of peeks (2, 4, or 8) and the
+// number of vertices (4 or 8) at runtime.
+inline bool IsBlocking(
+    const std::vector<FVector>& Peeks,
+    const FVector* TopVertices,
+    const FVector* BottomVertices,
+    int NumVertices,
+    const Cuboid* C)
+{
+    const FVector* P = Peeks.data();
+    switch (Peeks.size() * 16 + NumVertices)
+    {
+    case 2 * 16 + 4:
+        return IsBlocking<2, 4>(P, TopVertices, BottomVertices, C);
+    case 2 * 16 + 8:
+        return IsBlocking<2, 8>(P, TopVertices, BottomVertices, C);
+    case 4 * 16 + 4:
+        return IsBlocking<4, 4>(P, TopVertices, BottomVertices, C);
+    case 4 * 16 + 8:
+        return IsBlocking<4, 8>(P, TopVertices, BottomVertices, C);
+    case 8 * 16 + 4:
+        return IsBlocking<8, 4>(P, TopVertices, BottomVertices, C);
+    case 8 * 16 + 8:
+        return IsBlocking<8, 8>(P, TopVertices, BottomVertices, C);
+    default:
+        checkNoEntry();
+        return false;
+    }
+}
+
 // Checks if the Cuboid blocks visibility between a player and enemy,
 // returning true if and only if all lines of sights from the player's possible
 // peeks are blocked.
@@ -326,6 +656,11 @@ inline bool IsBlocking(
     const CharacterBounds& Bounds,
     const Cuboid* C)
 {
+    // Four peeks use the registers precomputed in the bounds.
+    if (Peeks.size() != 4)
+    {
+        return IsBlocking(Peeks, Bounds.TopVertices, Bounds.BottomVertices, 8, C);
+    }
     __m256 StartXs = _mm256_set_ps(
         Peeks[0].X, Peeks[0].X, Peeks[0].X, Peeks[0].X,
         Peeks[1].X, Peeks[1].X, Peeks[1].X, Peeks[1].X);
@@ -361,6 +696,282 @@ inline bool IsBlocking(
     }
 }
 
+// Builds a billboard for an enemy's bounding box: a vertical rectangle,
+// perpendicular to the horizontal line of sight, touching the near side of
+// the box and covering the box as seen from every peek. Every line of sight
+// from a peek to the box crosses the billboard first, so a cuboid that blocks
+// the billboard blocks the box. Peeks lie in a plane parallel to the
+// billboard, so covering the box as seen from the corner peeks covers it
+// from every peek in between.
+// Returns false if a peek is not in front of the box, or if there are more
+// than four peeks, which do not lie in a plane.
+inline bool MakeBillboard(
+    const std::vector<FVector>& Peeks,
+    const CharacterBounds& Bounds,
+    FVector BillboardVertices[4])
+{
+    if (Peeks.size() > 4)
+    {
+        return false;
+    }
+    FVector Camera = FVector::ZeroVector;
+    for (const FVector& P : Peeks)
+    {
+        Camera += P / Peeks.size();
+    }
+    FVector Normal =
+        FVector(Bounds.Center.X - Camera.X, Bounds.Center.Y - Camera.Y, 0).GetSafeNormal(1e-6);
+    if (Normal.IsZero())
+    {
+        return false;
+    }
+    FVector Side(-Normal.Y, Normal.X, 0);
+    FVector Vertices[CUBOID_V];
+    float Plane = std::numeric_limits<float>::infinity();
+    for (int k = 0; k < 4; k++)
+    {
+        Vertices[k] = Bounds.TopVertices[k];
+        Vertices[k + 4] = Bounds.BottomVertices[k];
+    }
+    for (const FVector& V : Vertices)
+    {
+        Plane = std::min(Plane, Normal | V);
+    }
+    float MinSide = std::numeric_limits<float>::infinity();
+    float MaxSide = -MinSide;
+    float MinZ = MinSide;
+    float MaxZ = -MinSide;
+    for (const FVector& P : Peeks)
+    {
+        float PeekDistance = Normal | P;
+        if (PeekDistance >= Plane)
+        {
+            return false;
+        }
+        // Project each vertex onto the billboard's plane as seen from the peek.
+        for (const FVector& V : Vertices)
+        {
+            float t = (Plane - PeekDistance) / ((Normal | V) - PeekDistance);
+            FVector Crossing = P + t * (V - P);
+            MinSide = std::min(MinSide, Side | Crossing);
+            MaxSide = std::max(MaxSide, Side | Crossing);
+            MinZ = std::min(MinZ, Crossing.Z);
+            MaxZ = std::max(MaxZ, Crossing.Z);
+        }
+    }
+    FVector Left = Plane * Normal + MinSide * Side;
+    FVector Right = Plane * Normal + MaxSide * Side;
+    BillboardVertices[0] = FVector(Left.X, Left.Y, MaxZ);
+    BillboardVertices[1] = FVector(Right.X, Right.Y, MaxZ);
+    BillboardVertices[2] = FVector(Left.X, Left.Y, MinZ);
+    BillboardVertices[3] = FVector(Right.X, Right.Y, MinZ);
+    return true;
+}
+
+// Checks if the Cuboid blocks visibility between a player and the billboard
+// of a distant enemy. As with IsBlocking, top peeks are tested against the
+// top corners and bottom peeks against the bottom corners, which for four
+// peeks is only 8 segments, or a single pass.
+inline bool IsBlockingBillboard(const Bundle& B, const Cuboid* C)
+{
+    return IsBlocking(B.PossiblePeeks, B.BillboardVertices, B.BillboardVertices + 2, 4, C);
+}
+
+// Number of line segments between peeks and bounding box vertices
+// tested by IsBlocking, and the mask with a bit set for every segment.
+constexpr int NUM_SEGMENTS = 16;
+constexpr int ALL_SEGMENTS_BLOCKED = (1 << NUM_SEGMENTS) - 1;
+
+// Checks which lines of sight tested by IsBlocking are blocked by the Cuboid.
+// Bits 0-7 are the lines of sight from the top peeks to the top vertices,
+// and bits 8-15 from the bottom peeks to the bottom vertices.
+// Lets the culler combine several cuboids that each block some of the
+// lines of sight.
+inline int BlockedSegments(
+    const std::vector<FVector>& Peeks,
+    const CharacterBounds& Bounds,
+    const Cuboid* C)
+{
+    __m256 StartXs = _mm256_set_ps(
+        Peeks[0].X, Peeks[0].X, Peeks[0].X, Peeks[0].X,
+        Peeks[1].X, Peeks[1].X, Peeks[1].X, Peeks[1].X);
+    __m256 StartYs = _mm256_set_ps(
+        Peeks[0].Y, Peeks[0].Y, Peeks[0].Y, Peeks[0].Y,
+        Peeks[1].Y, Peeks[1].Y, Peeks[1].Y, Peeks[1].Y);
+    __m256 StartZs = _mm256_set_ps(
+        Peeks[0].Z, Peeks[0].Z, Peeks[0].Z, Peeks[0].Z,
+        Peeks[1].Z, Peeks[1].Z, Peeks[1].Z, Peeks[1].Z);
+    int TopMask = IntersectionMask(
+        C,
+        StartXs, StartYs, StartZs,
+        Bounds.TopVerticesXs, Bounds.TopVerticesYs, Bounds.TopVerticesZs);
+    StartXs = _mm256_set_ps(
+        Peeks[2].X, Peeks[2].X, Peeks[2].X, Peeks[2].X,
+        Peeks[3].X, Peeks[3].X, Peeks[3].X, Peeks[3].X);
+    StartYs = _mm256_set_ps(
+        Peeks[2].Y, Peeks[2].Y, Peeks[2].Y, Peeks[2].Y,
+        Peeks[3].Y, Peeks[3].Y, Peeks[3].Y, Peeks[3].Y);
+    StartZs = _mm256_set_ps(
+        Peeks[2].Z, Peeks[2].Z, Peeks[2].Z, Peeks[2].Z,
+        Peeks[3].Z, Peeks[3].Z, Peeks[3].Z, Peeks[3].Z);
+    int BottomMask = IntersectionMask(
+        C,
+        StartXs, StartYs, StartZs,
+        Bounds.BottomVerticesXs, Bounds.BottomVerticesYs, Bounds.BottomVerticesZs);
+    return TopMask | (BottomMask << 8);
+}
+
+// Checks if the Cuboid blocks every line of sight between the convex hull of
+// a player's possible peeks and the convex hull of an enemy's bounding box.
+// A convex occluder blocks every segment between two convex hulls if and only
+// if it blocks every segment between their vertices, so this tests every peek
+// against all 8 vertices, including the top-to-bottom pairs that IsBlocking
+// skips. That makes it exact for any convex occluder, not only for prisms.
+// Each endpoint's distance to each face plane is computed once, and
+// Cyrus-Beck clipping of each segment then needs only their differences.
+// A face with a peek and a vertex both outside of it separates that segment
+// from the cuboid, which rejects most misses before any division.
+inline bool IsBlockingHull(
+    const std::vector<FVector>& Peeks,
+    const CharacterBounds& Bounds,
+    const Cuboid* C)
+{
+    const __m256 Zero = _mm256_setzero_ps();
+    // Pack the four top and four bottom vertices into one register.
+    __m256 Xs = _mm256_blend_ps(Bounds.TopVerticesXs, Bounds.BottomVerticesXs, 0xF0);
+    __m256 Ys = _mm256_blend_ps(Bounds.TopVerticesYs, Bounds.BottomVerticesYs, 0xF0);
+    __m256 Zs = _mm256_blend_ps(Bounds.TopVerticesZs, Bounds.BottomVerticesZs, 0xF0);
+    // Signed distances of each vertex outside of each face plane.
+    __m256 VertexDistances[CUBOID_F];
+    float Offsets[CUBOID_F];
+    bool VertexOutside[CUBOID_F];
+    for (int i = 0; i < CUBOID_F; i++)
+    {
+        const FVector& Normal = C->Faces[i].Normal;
+        Offsets[i] = Normal | C->GetVertex(i, 0);
+        VertexDistances[i] = _mm256_fmadd_ps(
+            Xs,
+            _mm256_set1_ps(Normal.X),
+            _mm256_fmadd_ps(
+                Ys,
+                _mm256_set1_ps(Normal.Y),
+                _mm256_fmsub_ps(
+                    Zs,
+                    _mm256_set1_ps(Normal.Z),
+                    _mm256_set1_ps(Offsets[i]))));
+        VertexOutside[i] =
+            0 != _mm256_movemask_ps(_mm256_cmp_ps(VertexDistances[i], Zero, _CMP_GT_OQ));
+        for (const FVector& Peek : Peeks)
+        {
+            if (VertexOutside[i] && (Normal | Peek) > Offsets[i])
+            {
+                return false;
+            }
+        }
+    }
+    for (const FVector& Peek : Peeks)
+    {
+        __m256 EnterTimes = Zero;
+        __m256 ExitTimes = _mm256_set1_ps(1);
+        for (int i = 0; i < CUBOID_F; i++)
+        {
+            __m256 PeekDistances = _mm256_set1_ps((C->Faces[i].Normal | Peek) - Offsets[i]);
+            // Segments parallel to a face have both endpoints inside of it,
+            // as the check above rejects those outside, so they are skipped.
+            __m256 Times = _mm256_div_ps(
+                PeekDistances,
+                _mm256_sub_ps(PeekDistances, VertexDistances[i]));
+            EnterTimes = _mm256_blendv_ps(
+                EnterTimes,
+                _mm256_max_ps(EnterTimes, Times),
+                _mm256_cmp_ps(PeekDistances, VertexDistances[i], _CMP_GT_OQ));
+            ExitTimes = _mm256_blendv_ps(
+                ExitTimes,
+                _mm256_min_ps(ExitTimes, Times),
+                _mm256_cmp_ps(VertexDistances[i], PeekDistances, _CMP_GT_OQ));
+        }
+        if (0 !=
+            _mm256_movemask_ps(_mm256_cmp_ps(EnterTimes, ExitTimes, _CMP_GT_OQ)))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Gets the greatest depth inside a cuboid reached by a line segment,
+// where depth is the distance to the nearest face plane.
+// Returns 0 if the segment misses the cuboid.
+// Depth along the segment is the minimum of the linear distances to each face
+// plane, so its maximum lies at an endpoint or where two distances cross.
+inline float MaxDepth(const Cuboid* C, const FVector& Start, const FVector& End)
+{
+    const FVector Delta = End - Start;
+    // Distance to face i at time t is Offsets[i] - t * Slopes[i].
+    float Offsets[CUBOID_F];
+    float Slopes[CUBOID_F];
+    for (int i = 0; i < CUBOID_F; i++)
+    {
+        Offsets[i] = C->Faces[i].Normal | (C->GetVertex(i, 0) - Start);
+        Slopes[i] = C->Faces[i].Normal | Delta;
+    }
+    auto DepthAt = [&](float t)
+    {
+        float Depth = Offsets[0] - t * Slopes[0];
+        for (int i = 1; i < CUBOID_F; i++)
+        {
+            Depth = std::min(Depth, Offsets[i] - t * Slopes[i]);
+        }
+        return Depth;
+    };
+    float Best = std::max(DepthAt(0), DepthAt(1));
+    for (int i = 0; i < CUBOID_F; i++)
+    {
+        for (int j = i + 1; j < CUBOID_F; j++)
+        {
+            if (Slopes[i] != Slopes[j])
+            {
+                float t = (Offsets[i] - Offsets[j]) / (Slopes[i] - Slopes[j]);
+                if (0 < t && t < 1)
+                {
+                    Best = std::max(Best, DepthAt(t));
+                }
+            }
+        }
+    }
+    return std::max(0.0f, Best);
+}
+
+// Gets how far each peek and each vertex of an enemy's bounding box can move
+// while the cuboid still blocks every line of sight tested by IsBlocking,
+// or by IsBlockingHull if AllPairs is set.
+// Every point of a segment moves no further than its endpoints do, so a
+// segment stays blocked if its endpoints move less than its depth in the cuboid.
+inline float BlockingMargin(
+    const std::vector<FVector>& Peeks,
+    const CharacterBounds& Bounds,
+    const Cuboid* C,
+    bool AllPairs = false)
+{
+    float Margin = std::numeric_limits<float>::infinity();
+    for (int i = 0; i < Peeks.size(); i++)
+    {
+        for (int Top = 0; Top < 2; Top++)
+        {
+            if (!AllPairs && Top != (i < Peeks.size() / 2))
+            {
+                continue;
+            }
+            const FVector (&Vertices)[4] = Top ? Bounds.TopVertices : Bounds.BottomVertices;
+            for (const FVector& V : Vertices)
+            {
+                Margin = std::min(Margin, MaxDepth(C, Peeks[i], V));
+            }
+        }
+    }
+    return Margin;
+}
+
 // Checks sphere intersection for all line segments between
 // a player's possible peeks and the vertices of an enemy's bounding box.
 // Uses sphere and line segment intersection with formula from:
@@ -376,8 +987,8 @@ inline bool IsBlocking(
     for (int i = 0; i < Peeks.size(); i++)
     {
         FVector PlayerToSphere = SphereCenter - Peeks[i];
-        const std::vector<FVector>* Vertices;
-        if (i < 2)
+        const FVector (*Vertices)[4];
+        if (i < Peeks.size() / 2)
         {
             Vertices = &Bounds.TopVertices;
         }
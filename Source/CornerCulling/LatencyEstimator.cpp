@@ -0,0 +1,63 @@
+#include "LatencyEstimator.h"
+#include "CornerCullingCharacter.h"
+#include "GameFramework/PlayerState.h"
+#include <algorithm>
+
+bool PlayerStateLatencySource::GetRoundTripTime(int i, float& Seconds)
+{
+    const APlayerState* State = Characters[i]->GetPlayerState();
+    if (State == NULL || State->ExactPing <= 0)
+    {
+        return false;
+    }
+    Seconds = State->ExactPing / 1000;
+    return true;
+}
+
+bool SimulatedLatencySource::GetRoundTripTime(int i, float& Seconds)
+{
+    Seconds = Base + Random.FRandRange(0, Jitter);
+    if (Random.FRand() < SpikeChance)
+    {
+        Seconds += Random.FRandRange(0, SpikeSize);
+    }
+    return true;
+}
+
+void LatencyEstimator::Reset(int NumPlayers, float NewDefaultLatency)
+{
+    DefaultLatency = NewDefaultLatency;
+    Samples.assign(NumPlayers, std::vector<float>());
+    NextSample.assign(NumPlayers, 0);
+    Estimates.assign(NumPlayers, DefaultLatency);
+}
+
+void LatencyEstimator::Update(ILatencySource& Source)
+{
+    for (int i = 0; i < Samples.size(); i++)
+    {
+        float Seconds;
+        if (Source.GetRoundTripTime(i, Seconds))
+        {
+            AddSample(i, Seconds);
+        }
+    }
+}
+
+void LatencyEstimator::AddSample(int i, float Seconds)
+{
+    std::vector<float>& Window = Samples[i];
+    if (Window.size() < WindowSize)
+    {
+        Window.emplace_back(Seconds);
+    }
+    else
+    {
+        Window[NextSample[i]] = Seconds;
+    }
+    NextSample[i] = (NextSample[i] + 1) % WindowSize;
+    std::vector<float> Sorted = Window;
+    int Rank = FMath::Min(int(Percentile * Sorted.size()), int(Sorted.size()) - 1);
+    std::nth_element(Sorted.begin(), Sorted.begin() + Rank, Sorted.end());
+    Estimates[i] = Sorted[Rank] + Margin;
+}
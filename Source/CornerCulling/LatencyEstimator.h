@@ -0,0 +1,84 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Math/RandomStream.h"
+#include <vector>
+
+class ACornerCullingCharacter;
+
+// Source of round-trip time samples of each player's connection.
+class ILatencySource
+{
+public:
+    virtual ~ILatencySource() {}
+    // Gets the latest round-trip time of player i in seconds.
+    // Returns false if there is no sample, such as for bots.
+    virtual bool GetRoundTripTime(int i, float& Seconds) = 0;
+};
+
+// Reads the ping that the engine measures for each player's connection.
+class PlayerStateLatencySource : public ILatencySource
+{
+    const std::vector<ACornerCullingCharacter*>& Characters;
+
+public:
+    PlayerStateLatencySource(const std::vector<ACornerCullingCharacter*>& Characters)
+        : Characters(Characters) {}
+    bool GetRoundTripTime(int i, float& Seconds) override;
+};
+
+// Simulates connections with a base round-trip time, uniform jitter, and
+// occasional spikes, for testing without real clients.
+class SimulatedLatencySource : public ILatencySource
+{
+    FRandomStream Random;
+    float Base;
+    float Jitter;
+    float SpikeChance;
+    float SpikeSize;
+
+public:
+    SimulatedLatencySource(
+        float Base,
+        float Jitter = 0.01f,
+        float SpikeChance = 0.02f,
+        float SpikeSize = 0.1f,
+        int Seed = 0)
+        : Random(Seed), Base(Base), Jitter(Jitter), SpikeChance(SpikeChance), SpikeSize(SpikeSize) {}
+    bool GetRoundTripTime(int i, float& Seconds) override;
+};
+
+// Estimates a latency per player that the true latency rarely exceeds:
+// a high percentile of a window of recent round-trip times plus a margin.
+// Spiky connections have wide windows, so they get larger estimates.
+// The round-trip time stands in for the one-way latency, as the split between
+// the two directions is unknown; this overestimates it, which only makes
+// culling more conservative.
+class LatencyEstimator
+{
+    // Ring buffer of the latest samples of each player.
+    std::vector<std::vector<float>> Samples;
+    std::vector<int> NextSample;
+    std::vector<float> Estimates;
+    float DefaultLatency = 0;
+
+public:
+    // Number of samples kept per player.
+    int WindowSize = 64;
+    // Fraction of samples that the estimate must cover, before the margin.
+    float Percentile = 0.95f;
+    // Seconds added to every estimate.
+    float Margin = 0.01f;
+
+    // Forgets all samples. Players without samples get DefaultLatency.
+    void Reset(int NumPlayers, float NewDefaultLatency);
+    // Takes a sample of every player from Source and updates the estimates.
+    void Update(ILatencySource& Source);
+    // Adds a sample of player i in seconds and updates its estimate.
+    void AddSample(int i, float Seconds);
+    // Gets the estimated latency of player i in seconds.
+    float GetLatency(int i) const
+    {
+        return (i < Estimates.size()) ? Estimates[i] : DefaultLatency;
+    }
+};
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+
+// State of a character after it moved, pushed to the culler.
+struct MovementRecord
+{
+    // Index of the character in the culler.
+    int32 Id;
+    // Frame that the record was taken on.
+    int32 Tick;
+    FVector CameraLocation;
+    FTransform Transform;
+    FVector Velocity;
+};
+
+// Lock-free queue that any thread can push movement records to,
+// and that only the culler drains.
+typedef TQueue<MovementRecord, EQueueMode::Mpsc> MovementQueue;
@@ -0,0 +1,82 @@
+#include "OccluderFusion.h"
+#include "OccluderSimplification.h"
+#include <numeric>
+
+void OccluderFusion::Build(const std::vector<Cuboid>& Cuboids, float Tolerance)
+{
+    Joints.clear();
+    Partners.clear();
+    int N = Cuboids.size();
+    std::vector<FBox> Boxes;
+    std::vector<OrientedBox> OrientedBoxes(N);
+    std::vector<bool> IsBox;
+    for (int i = 0; i < N; i++)
+    {
+        Boxes.emplace_back(FBox(Cuboids[i].Vertices, CUBOID_V));
+        IsBox.emplace_back(OrientedBoxes[i].FromCuboid(Cuboids[i], Tolerance));
+    }
+    // Sweep along X so that only nearby cuboids are compared.
+    std::vector<int> Order(N);
+    std::iota(Order.begin(), Order.end(), 0);
+    std::sort(
+        Order.begin(),
+        Order.end(),
+        [&Boxes](int i, int j) { return Boxes[i].Min.X < Boxes[j].Min.X; });
+    for (int a = 0; a < N; a++)
+    {
+        int i = Order[a];
+        if (!IsBox[i])
+        {
+            continue;
+        }
+        for (int b = a + 1; b < N; b++)
+        {
+            int j = Order[b];
+            if (Boxes[j].Min.X > Boxes[i].Max.X + Tolerance)
+            {
+                break;
+            }
+            if (!IsBox[j] || !Boxes[i].ExpandBy(Tolerance).Intersect(Boxes[j]))
+            {
+                continue;
+            }
+            OrientedBox Joint;
+            if (JoinBoxes(OrientedBoxes[i], OrientedBoxes[j], Tolerance, Joint))
+            {
+                Joints.emplace_back(Joint.ToCuboid());
+                const Cuboid* JointP = &Joints.back();
+                Partners[&Cuboids[i]].emplace_back(FusionPartner { &Cuboids[j], JointP });
+                Partners[&Cuboids[j]].emplace_back(FusionPartner { &Cuboids[i], JointP });
+            }
+        }
+    }
+}
+
+const Cuboid* OccluderFusion::FindBlocker(
+    const Cuboid* C,
+    const std::vector<FVector>& Peeks,
+    const CharacterBounds& Bounds) const
+{
+    int Mask = BlockedSegments(Peeks, Bounds, C);
+    if (Mask == ALL_SEGMENTS_BLOCKED)
+    {
+        return C;
+    }
+    const std::vector<FusionPartner>* CPartners = GetPartners(C);
+    if (Mask == 0 || CPartners == NULL)
+    {
+        return NULL;
+    }
+    for (const FusionPartner& Partner : *CPartners)
+    {
+        // The pair can only block the bundle if, between them,
+        // every line of sight is blocked.
+        int NeighborMask = BlockedSegments(Peeks, Bounds, Partner.Neighbor);
+        if ((Mask | NeighborMask) == ALL_SEGMENTS_BLOCKED
+            && IsBlocking(Peeks, Bounds, Partner.Joint))
+        {
+            return Partner.Joint;
+        }
+    }
+    return NULL;
+}
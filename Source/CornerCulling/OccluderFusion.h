@@ -0,0 +1,52 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GeometricPrimitives.h"
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+// A cuboid that touches another cuboid, and the joint cuboid that the two
+// form together.
+struct FusionPartner
+{
+    const Cuboid* Neighbor;
+    const Cuboid* Joint;
+};
+
+// Lets several touching cuboids jointly block a bundle.
+// IsBlocking only trusts a single convex occluder, because lines of sight can
+// slip through gaps between occluders. So instead of trusting the union of
+// blocked segments directly, we precompute, for each pair of touching boxes,
+// the largest box inside their union that spans both of them. When two
+// neighbors' blocked segments together cover the whole bundle, the joint box
+// is tested, and it is what gets cached.
+class OccluderFusion
+{
+    // Joint cuboids. A deque keeps their addresses stable for the caches.
+    std::deque<Cuboid> Joints;
+    // Touching neighbors of each cuboid.
+    std::unordered_map<const Cuboid*, std::vector<FusionPartner>> Partners;
+
+public:
+    // Finds all touching pairs of box-shaped cuboids and builds their joints.
+    // Cuboids must not be moved or reallocated afterwards.
+    void Build(const std::vector<Cuboid>& Cuboids, float Tolerance);
+    // Gets the touching neighbors of a cuboid, or NULL if it has none.
+    const std::vector<FusionPartner>* GetPartners(const Cuboid* C) const
+    {
+        auto It = Partners.find(C);
+        return It == Partners.end() ? NULL : &It->second;
+    }
+    // Checks if a cuboid blocks a bundle, alone or together with one of its
+    // touching neighbors. Returns the cuboid or joint cuboid that blocks
+    // the bundle, or NULL.
+    const Cuboid* FindBlocker(
+        const Cuboid* C,
+        const std::vector<FVector>& Peeks,
+        const CharacterBounds& Bounds) const;
+    int NumJoints() const
+    {
+        return Joints.size();
+    }
+};
@@ -0,0 +1,60 @@
+#include "OccluderHints.h"
+
+// Bits per quantized coordinate. Cell coordinates wrap around, which only
+// makes distant cells share hints.
+constexpr int HINT_KEY_BITS = 10;
+constexpr int HINT_KEY_MASK = (1 << HINT_KEY_BITS) - 1;
+
+uint64 OccluderHints::GetKey(const FVector& Player, const FVector& Enemy) const
+{
+    const float Coordinates[6] =
+    {
+        Player.X, Player.Y, Player.Z,
+        Enemy.X, Enemy.Y, Enemy.Z
+    };
+    uint64 Key = 0;
+    for (int k = 0; k < 6; k++)
+    {
+        int Cell = FMath::FloorToInt(Coordinates[k] / CellSize);
+        Key = (Key << HINT_KEY_BITS) | (uint64(Cell) & HINT_KEY_MASK);
+    }
+    return Key;
+}
+
+void OccluderHints::Reset(float NewCellSize)
+{
+    Entries.Reset();
+    CellSize = NewCellSize;
+    Lookups = 0;
+    Hits = 0;
+}
+
+const Cuboid* const* OccluderHints::Find(const FVector& Player, const FVector& Enemy)
+{
+    Lookups++;
+    const Entry* E = Entries.Find(GetKey(Player, Enemy));
+    return E ? E->Cuboids : NULL;
+}
+
+void OccluderHints::Insert(const FVector& Player, const FVector& Enemy, const Cuboid* C)
+{
+    uint64 Key = GetKey(Player, Enemy);
+    Entry* E = Entries.Find(Key);
+    if (E == NULL)
+    {
+        if (Entries.Num() >= MAX_HINT_KEYS)
+        {
+            Entries.Reset();
+        }
+        E = &Entries.Add(Key);
+    }
+    for (int k = 0; k < HINTS_PER_KEY; k++)
+    {
+        if (E->Cuboids[k] == C)
+        {
+            return;
+        }
+    }
+    E->Cuboids[E->Next] = C;
+    E->Next = (E->Next + 1) % HINTS_PER_KEY;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GeometricPrimitives.h"
+#include "Containers/Map.h"
+
+// Number of recent blocking cuboids kept per pair of cells.
+constexpr int HINTS_PER_KEY = 4;
+// Number of keys above which the hints are cleared, bounding memory.
+constexpr int MAX_HINT_KEYS = 1 << 16;
+
+// Cuboids that recently blocked lines of sight between two regions of the map,
+// keyed by the quantized locations of a player's camera and an enemy's center.
+// Nearby players usually share blockers, so a pair that has just formed can
+// try its neighbors' blockers before traversing the BVH.
+// Hints are only candidates. Keys may collide, so every hint must be
+// confirmed with a blocking test before culling.
+class OccluderHints
+{
+    struct Entry
+    {
+        const Cuboid* Cuboids[HINTS_PER_KEY] = { 0 };
+        // Slot to overwrite next.
+        int Next = 0;
+    };
+    TMap<uint64, Entry> Entries;
+    float CellSize = 400;
+
+    uint64 GetKey(const FVector& Player, const FVector& Enemy) const;
+
+public:
+    // Lookups and hits since the counters were last reset.
+    int Lookups = 0;
+    int Hits = 0;
+
+    // Removes all hints and sets the side length of cells.
+    void Reset(float NewCellSize);
+    // Gets the HINTS_PER_KEY most recent blockers of pairs in these cells,
+    // with unused slots set to NULL, or NULL if there are none.
+    // Counts a lookup.
+    const Cuboid* const* Find(const FVector& Player, const FVector& Enemy);
+    // Records that C blocked a pair in these cells.
+    void Insert(const FVector& Player, const FVector& Enemy, const Cuboid* C);
+};
@@ -0,0 +1,335 @@
+#include "OccluderSimplification.h"
+#include <numeric>
+
+// Sign of each axis for each vertex in the standard cuboid layout.
+constexpr float VertexSigns[CUBOID_V][3] =
+{
+     1,  1,  1,
+    -1,  1,  1,
+    -1, -1,  1,
+     1, -1,  1,
+     1,  1, -1,
+    -1,  1, -1,
+    -1, -1, -1,
+     1, -1, -1
+};
+
+// Cosine above which two axes are considered parallel.
+constexpr float PARALLEL_COSINE = 1 - 1e-4f;
+
+bool OrientedBox::FromCuboid(const Cuboid& C, float Tolerance)
+{
+    Center = FVector::ZeroVector;
+    for (int i = 0; i < CUBOID_V; i++)
+    {
+        Center += C.Vertices[i];
+    }
+    Center /= CUBOID_V;
+    const FVector Edges[3] =
+    {
+        C.Vertices[0] - C.Vertices[1],
+        C.Vertices[0] - C.Vertices[3],
+        C.Vertices[0] - C.Vertices[4]
+    };
+    for (int k = 0; k < 3; k++)
+    {
+        float Length = Edges[k].Size();
+        if (Length <= Tolerance)
+        {
+            return false;
+        }
+        Axes[k] = Edges[k] / Length;
+        Extents[k] = Length / 2;
+    }
+    for (int k = 0; k < 3; k++)
+    {
+        if (FMath::Abs(Axes[k] | Axes[(k + 1) % 3]) > 1e-3f)
+        {
+            return false;
+        }
+    }
+    // Reject skewed cuboids whose vertices do not match the box.
+    for (int i = 0; i < CUBOID_V; i++)
+    {
+        FVector V = Center;
+        for (int k = 0; k < 3; k++)
+        {
+            V += VertexSigns[i][k] * Extents[k] * Axes[k];
+        }
+        if (FVector::Dist(V, C.Vertices[i]) > Tolerance)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+Cuboid OrientedBox::ToCuboid() const
+{
+    TArray<FVector> Vertices;
+    for (int i = 0; i < CUBOID_V; i++)
+    {
+        FVector V = Center;
+        for (int k = 0; k < 3; k++)
+        {
+            V += VertexSigns[i][k] * Extents[k] * Axes[k];
+        }
+        Vertices.Emplace(V);
+    }
+    return Cuboid(Vertices);
+}
+
+bool IsContained(const Cuboid& Inner, const Cuboid& Outer, float Tolerance)
+{
+    for (int i = 0; i < CUBOID_F; i++)
+    {
+        const FVector& Normal = Outer.Faces[i].Normal;
+        const FVector& FaceVertex = Outer.GetVertex(i, 0);
+        for (int j = 0; j < CUBOID_V; j++)
+        {
+            if ((Normal | (Inner.Vertices[j] - FaceVertex)) > Tolerance)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Gets the interval of each box along each of A's axes, relative to A's center.
+// Returns false if the axes of the boxes are not parallel.
+static bool GetIntervals(
+    const OrientedBox& A,
+    const OrientedBox& B,
+    float ALow[3],
+    float AHigh[3],
+    float BLow[3],
+    float BHigh[3])
+{
+    FVector CenterOffset = B.Center - A.Center;
+    for (int k = 0; k < 3; k++)
+    {
+        int Match = -1;
+        for (int m = 0; m < 3; m++)
+        {
+            if (FMath::Abs(A.Axes[k] | B.Axes[m]) >= PARALLEL_COSINE)
+            {
+                Match = m;
+                break;
+            }
+        }
+        if (Match < 0)
+        {
+            return false;
+        }
+        float Offset = CenterOffset | A.Axes[k];
+        ALow[k] = -A.Extents[k];
+        AHigh[k] = A.Extents[k];
+        BLow[k] = Offset - B.Extents[Match];
+        BHigh[k] = Offset + B.Extents[Match];
+    }
+    return true;
+}
+
+// Sets Result to the box spanning the union of the intervals along JoinAxis
+// and their intersection along the other axes, in A's frame.
+static void JoinIntervals(
+    const OrientedBox& A,
+    const float ALow[3],
+    const float AHigh[3],
+    const float BLow[3],
+    const float BHigh[3],
+    int JoinAxis,
+    OrientedBox& Result)
+{
+    Result.Center = A.Center;
+    for (int k = 0; k < 3; k++)
+    {
+        float Low, High;
+        if (k == JoinAxis)
+        {
+            Low = std::min(ALow[k], BLow[k]);
+            High = std::max(AHigh[k], BHigh[k]);
+        }
+        else
+        {
+            Low = std::max(ALow[k], BLow[k]);
+            High = std::min(AHigh[k], BHigh[k]);
+        }
+        Result.Axes[k] = A.Axes[k];
+        Result.Extents[k] = (High - Low) / 2;
+        Result.Center += ((High + Low) / 2) * A.Axes[k];
+    }
+}
+
+bool MergeBoxes(
+    const OrientedBox& A,
+    const OrientedBox& B,
+    float Tolerance,
+    OrientedBox& Merged)
+{
+    float ALow[3], AHigh[3], BLow[3], BHigh[3];
+    if (!GetIntervals(A, B, ALow, AHigh, BLow, BHigh))
+    {
+        return false;
+    }
+    // Find the single axis along which the boxes differ.
+    int JoinAxis = -1;
+    for (int k = 0; k < 3; k++)
+    {
+        bool Matches =
+            FMath::Abs(ALow[k] - BLow[k]) <= Tolerance
+            && FMath::Abs(AHigh[k] - BHigh[k]) <= Tolerance;
+        if (!Matches)
+        {
+            if (JoinAxis >= 0)
+            {
+                return false;
+            }
+            JoinAxis = k;
+        }
+    }
+    // Identical boxes are handled as containment.
+    if (JoinAxis < 0)
+    {
+        return false;
+    }
+    // The boxes must touch or overlap along the join axis. Bridging a gap,
+    // however small, would hide what is seen through it.
+    if (BLow[JoinAxis] > AHigh[JoinAxis] || ALow[JoinAxis] > BHigh[JoinAxis])
+    {
+        return false;
+    }
+    // Along the matching axes, keep the shared faces inside both boxes.
+    JoinIntervals(A, ALow, AHigh, BLow, BHigh, JoinAxis, Merged);
+    return true;
+}
+
+bool JoinBoxes(
+    const OrientedBox& A,
+    const OrientedBox& B,
+    float Tolerance,
+    OrientedBox& Joint)
+{
+    float ALow[3], AHigh[3], BLow[3], BHigh[3];
+    if (!GetIntervals(A, B, ALow, AHigh, BLow, BHigh))
+    {
+        return false;
+    }
+    float Overlap[3];
+    for (int k = 0; k < 3; k++)
+    {
+        Overlap[k] = std::min(AHigh[k], BHigh[k]) - std::max(ALow[k], BLow[k]);
+        // The joint box spans the union along one axis, so the boxes must
+        // touch without a gap.
+        if (Overlap[k] < 0)
+        {
+            return false;
+        }
+    }
+    float VolumeA = A.Extents[0] * A.Extents[1] * A.Extents[2];
+    float VolumeB = B.Extents[0] * B.Extents[1] * B.Extents[2];
+    float BestVolume = std::max(VolumeA, VolumeB);
+    int BestAxis = -1;
+    for (int k = 0; k < 3; k++)
+    {
+        float Union = std::max(AHigh[k], BHigh[k]) - std::min(ALow[k], BLow[k]);
+        float Volume =
+            Union * Overlap[(k + 1) % 3] * Overlap[(k + 2) % 3] / 8;
+        if (Overlap[(k + 1) % 3] > Tolerance
+            && Overlap[(k + 2) % 3] > Tolerance
+            && Volume > BestVolume)
+        {
+            BestVolume = Volume;
+            BestAxis = k;
+        }
+    }
+    if (BestAxis < 0)
+    {
+        return false;
+    }
+    JoinIntervals(A, ALow, AHigh, BLow, BHigh, BestAxis, Joint);
+    return true;
+}
+
+SimplificationStats SimplifyCuboids(
+    std::vector<Cuboid>& Cuboids,
+    float Tolerance)
+{
+    SimplificationStats Stats;
+    Stats.CuboidsBefore = Cuboids.size();
+    bool Changed = true;
+    while (Changed)
+    {
+        Changed = false;
+        int N = Cuboids.size();
+        std::vector<FBox> Boxes;
+        std::vector<OrientedBox> OrientedBoxes(N);
+        std::vector<bool> IsBox;
+        std::vector<bool> Removed(N, false);
+        for (int i = 0; i < N; i++)
+        {
+            Boxes.emplace_back(FBox(Cuboids[i].Vertices, CUBOID_V));
+            IsBox.emplace_back(OrientedBoxes[i].FromCuboid(Cuboids[i], Tolerance));
+        }
+        // Sweep along X so that only nearby cuboids are compared.
+        std::vector<int> Order(N);
+        std::iota(Order.begin(), Order.end(), 0);
+        std::sort(
+            Order.begin(),
+            Order.end(),
+            [&Boxes](int i, int j) { return Boxes[i].Min.X < Boxes[j].Min.X; });
+        for (int a = 0; a < N; a++)
+        {
+            int i = Order[a];
+            for (int b = a + 1; b < N && !Removed[i]; b++)
+            {
+                int j = Order[b];
+                if (Boxes[j].Min.X > Boxes[i].Max.X + Tolerance)
+                {
+                    break;
+                }
+                if (Removed[j] || !Boxes[i].ExpandBy(Tolerance).Intersect(Boxes[j]))
+                {
+                    continue;
+                }
+                if (IsContained(Cuboids[j], Cuboids[i], Tolerance))
+                {
+                    Removed[j] = true;
+                    Stats.Contained++;
+                }
+                else if (IsContained(Cuboids[i], Cuboids[j], Tolerance))
+                {
+                    Removed[i] = true;
+                    Stats.Contained++;
+                }
+                else if (IsBox[i] && IsBox[j])
+                {
+                    OrientedBox Merged;
+                    if (MergeBoxes(OrientedBoxes[i], OrientedBoxes[j], Tolerance, Merged))
+                    {
+                        Cuboids[i] = Merged.ToCuboid();
+                        OrientedBoxes[i] = Merged;
+                        Boxes[i] = FBox(Cuboids[i].Vertices, CUBOID_V);
+                        Removed[j] = true;
+                        Stats.Merged++;
+                        // The merged cuboid may now merge with cuboids that
+                        // were already swept past, so sweep again.
+                        Changed = true;
+                    }
+                }
+            }
+        }
+        std::vector<Cuboid> Remaining;
+        for (int i = 0; i < N; i++)
+        {
+            if (!Removed[i])
+            {
+                Remaining.emplace_back(Cuboids[i]);
+            }
+        }
+        Cuboids = Remaining;
+    }
+    Stats.CuboidsAfter = Cuboids.size();
+    return Stats;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GeometricPrimitives.h"
+#include <vector>
+
+// Distance, in world units, within which faces are considered coplanar
+// and extents are considered to match. Merging never bridges gaps, so
+// cuboids must touch or overlap to merge.
+constexpr float MERGE_TOLERANCE = 1.0f;
+
+// Counts of occluding cuboids before and after simplification.
+struct SimplificationStats
+{
+    int CuboidsBefore = 0;
+    int CuboidsAfter = 0;
+    // Number of pairwise merges performed.
+    int Merged = 0;
+    // Number of cuboids dropped because another cuboid contained them.
+    int Contained = 0;
+};
+
+// A cuboid whose faces are rectangles meeting at right angles,
+// stored as a center, three orthonormal axes, and half-extents.
+// Axes are ordered to match the vertex layout of Cuboid:
+//   Axes[0] points from V1 to V0,
+//   Axes[1] points from V3 to V0,
+//   Axes[2] points from V4 to V0.
+struct OrientedBox
+{
+    FVector Center;
+    FVector Axes[3];
+    float Extents[3];
+    // Converts a cuboid into a box, returning false if the cuboid
+    // is not a rectangular box within the tolerance.
+    bool FromCuboid(const Cuboid& C, float Tolerance);
+    // Converts the box back into a cuboid with the standard vertex layout.
+    Cuboid ToCuboid() const;
+};
+
+// Checks if every vertex of Inner lies within Tolerance of Outer.
+bool IsContained(const Cuboid& Inner, const Cuboid& Outer, float Tolerance);
+
+// Merges two boxes that share a face into a single box.
+// Succeeds only when the boxes have parallel axes, their extents match along
+// two axes, and they touch or overlap along the third, with no gap between
+// them. Matching extents are trimmed to the shared face. The union of such
+// boxes is itself a box, so the merged occluder never hides anything that
+// the two original occluders did not.
+bool MergeBoxes(
+    const OrientedBox& A,
+    const OrientedBox& B,
+    float Tolerance,
+    OrientedBox& Merged);
+
+// Finds the largest box inside the union of two touching boxes that extends
+// across both of them. The joint box spans the union of the boxes along one
+// axis and their overlap along the other two, so it is contained in the two
+// boxes together and occludes only what they occlude jointly.
+// Fails if the axes are not parallel, the boxes do not touch, or the joint
+// box would be no larger than either box.
+bool JoinBoxes(
+    const OrientedBox& A,
+    const OrientedBox& B,
+    float Tolerance,
+    OrientedBox& Joint);
+
+// Merges coplanar, touching cuboids into larger cuboids and removes cuboids
+// that are fully contained in others. Runs until no further merges apply.
+// Fewer, larger occluders mean a smaller BVH and more culls by a single
+// cuboid, which is what IsBlocking requires.
+SimplificationStats SimplifyCuboids(
+    std::vector<Cuboid>& Cuboids,
+    float Tolerance = MERGE_TOLERANCE);
@@ -0,0 +1,177 @@
+#include "OcclusionRasterizer.h"
+
+OcclusionRasterizer::OcclusionRasterizer()
+{
+    for (int Row = 0; Row < RASTER_HEIGHT; Row++)
+    {
+        float Elevation = PI * ((Row + 0.5f) / RASTER_HEIGHT - 0.5f);
+        for (int Col = 0; Col < RASTER_WIDTH; Col++)
+        {
+            float Azimuth = 2 * PI * ((Col + 0.5f) / RASTER_WIDTH - 0.5f);
+            int Pixel = Row * RASTER_WIDTH + Col;
+            DirectionXs[Pixel] = FMath::Cos(Elevation) * FMath::Cos(Azimuth);
+            DirectionYs[Pixel] = FMath::Cos(Elevation) * FMath::Sin(Azimuth);
+            DirectionZs[Pixel] = FMath::Sin(Elevation);
+        }
+    }
+    Clear(FVector::ZeroVector);
+}
+
+void OcclusionRasterizer::Clear(const FVector& NewOrigin)
+{
+    Origin = NewOrigin;
+    std::fill(Depths, Depths + RASTER_PIXELS, std::numeric_limits<float>::infinity());
+    std::fill(IDs, IDs + RASTER_PIXELS, -1);
+}
+
+void OcclusionRasterizer::GetRect(
+    const FVector* Points,
+    int Count,
+    int& Col0,
+    int& Col1,
+    int& Row0,
+    int& Row1) const
+{
+    FVector Mean = FVector::ZeroVector;
+    for (int i = 0; i < Count; i++)
+    {
+        Mean += Points[i];
+    }
+    Mean = Mean / Count - Origin;
+    // Measure azimuths relative to the mean so that the range does not wrap.
+    float MeanAzimuth = FMath::Atan2(Mean.Y, Mean.X);
+    float MinAzimuth = 0, MaxAzimuth = 0;
+    float MinElevation = HALF_PI, MaxElevation = -HALF_PI;
+    for (int i = 0; i < Count; i++)
+    {
+        FVector D = Points[i] - Origin;
+        float Azimuth = FMath::UnwindRadians(FMath::Atan2(D.Y, D.X) - MeanAzimuth);
+        float Elevation = FMath::Atan2(D.Z, FVector2D(D.X, D.Y).Size());
+        MinAzimuth = std::min(MinAzimuth, Azimuth);
+        MaxAzimuth = std::max(MaxAzimuth, Azimuth);
+        MinElevation = std::min(MinElevation, Elevation);
+        MaxElevation = std::max(MaxElevation, Elevation);
+    }
+    float ColScale = RASTER_WIDTH / (2 * PI);
+    float RowScale = RASTER_HEIGHT / PI;
+    Col0 = FMath::FloorToInt((MeanAzimuth + MinAzimuth + PI) * ColScale);
+    Col1 = FMath::FloorToInt((MeanAzimuth + MaxAzimuth + PI) * ColScale);
+    Row0 = FMath::Clamp(FMath::FloorToInt((MinElevation + HALF_PI) * RowScale), 0, RASTER_HEIGHT - 1);
+    Row1 = FMath::Clamp(FMath::FloorToInt((MaxElevation + HALF_PI) * RowScale), 0, RASTER_HEIGHT - 1);
+}
+
+void OcclusionRasterizer::Rasterize(const Cuboid* C, int ID)
+{
+    // Precompute the numerator of the intersection time of each face.
+    float Nums[CUBOID_F];
+    bool Inside = true;
+    for (int i = 0; i < CUBOID_F; i++)
+    {
+        Nums[i] = C->Faces[i].Normal | (C->GetVertex(i, 0) - Origin);
+        Inside &= Nums[i] >= 0;
+    }
+    // A cuboid containing the origin would hide every other cuboid.
+    if (Inside)
+    {
+        return;
+    }
+    int Col0, Col1, Row0, Row1;
+    GetRect(C->Vertices, CUBOID_V, Col0, Col1, Row0, Row1);
+    // Edges of a cuboid may bulge past the angular bounds of its vertices,
+    // so pad the rectangle by a pixel.
+    Col0--;
+    Col1++;
+    Row0 = std::max(Row0 - 1, 0);
+    Row1 = std::min(Row1 + 1, RASTER_HEIGHT - 1);
+    int Block0 = FMath::FloorToInt(Col0 / 8.0f);
+    int Block1 = FMath::FloorToInt(Col1 / 8.0f);
+    constexpr int NumBlocks = RASTER_WIDTH / 8;
+    if (Block1 - Block0 >= NumBlocks)
+    {
+        Block0 = 0;
+        Block1 = NumBlocks - 1;
+    }
+    const __m256 Zero = _mm256_setzero_ps();
+    const __m256 IDVector = _mm256_castsi256_ps(_mm256_set1_epi32(ID));
+    for (int Row = Row0; Row <= Row1; Row++)
+    {
+        for (int Block = Block0; Block <= Block1; Block++)
+        {
+            int Pixel = Row * RASTER_WIDTH + 8 * (((Block % NumBlocks) + NumBlocks) % NumBlocks);
+            __m256 Xs = _mm256_loadu_ps(DirectionXs + Pixel);
+            __m256 Ys = _mm256_loadu_ps(DirectionYs + Pixel);
+            __m256 Zs = _mm256_loadu_ps(DirectionZs + Pixel);
+            __m256 EnterTimes = Zero;
+            __m256 ExitTimes = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+            __m256 Missed = Zero;
+            for (int i = 0; i < CUBOID_F; i++)
+            {
+                const FVector& Normal = C->Faces[i].Normal;
+                __m256 NumsVector = _mm256_set1_ps(Nums[i]);
+                __m256 Denoms =
+                    _mm256_fmadd_ps(
+                        Xs,
+                        _mm256_set1_ps(Normal.X),
+                        _mm256_fmadd_ps(
+                            Ys,
+                            _mm256_set1_ps(Normal.Y),
+                            _mm256_mul_ps(Zs, _mm256_set1_ps(Normal.Z))));
+                // Rays parallel to and outside of a face.
+                Missed = _mm256_or_ps(
+                    Missed,
+                    _mm256_and_ps(
+                        _mm256_cmp_ps(Denoms, Zero, _CMP_EQ_OQ),
+                        _mm256_cmp_ps(NumsVector, Zero, _CMP_LT_OQ)));
+                __m256 Times = _mm256_div_ps(NumsVector, Denoms);
+                EnterTimes = _mm256_blendv_ps(
+                    EnterTimes,
+                    _mm256_max_ps(EnterTimes, Times),
+                    _mm256_cmp_ps(Denoms, Zero, _CMP_LT_OS));
+                ExitTimes = _mm256_blendv_ps(
+                    ExitTimes,
+                    _mm256_min_ps(ExitTimes, Times),
+                    _mm256_cmp_ps(Denoms, Zero, _CMP_GT_OS));
+            }
+            __m256 OldDepths = _mm256_loadu_ps(Depths + Pixel);
+            __m256 Hits = _mm256_andnot_ps(
+                Missed,
+                _mm256_and_ps(
+                    _mm256_cmp_ps(EnterTimes, ExitTimes, _CMP_LE_OQ),
+                    _mm256_cmp_ps(EnterTimes, OldDepths, _CMP_LT_OQ)));
+            if (_mm256_movemask_ps(Hits) != 0)
+            {
+                _mm256_storeu_ps(Depths + Pixel, _mm256_blendv_ps(OldDepths, EnterTimes, Hits));
+                float* IDPixels = reinterpret_cast<float*>(IDs + Pixel);
+                _mm256_storeu_ps(
+                    IDPixels,
+                    _mm256_blendv_ps(_mm256_loadu_ps(IDPixels), IDVector, Hits));
+            }
+        }
+    }
+}
+
+void OcclusionRasterizer::GetCandidates(
+    const CharacterBounds& Bounds,
+    std::vector<int>& Candidates) const
+{
+    FVector Points[CUBOID_V];
+    for (int i = 0; i < 4; i++)
+    {
+        Points[i] = Bounds.TopVertices[i];
+        Points[i + 4] = Bounds.BottomVertices[i];
+    }
+    int Col0, Col1, Row0, Row1;
+    GetRect(Points, CUBOID_V, Col0, Col1, Row0, Row1);
+    Col1 = std::min(Col1, Col0 + RASTER_WIDTH - 1);
+    for (int Row = Row0; Row <= Row1; Row++)
+    {
+        for (int Col = Col0; Col <= Col1; Col++)
+        {
+            int ID = IDs[Row * RASTER_WIDTH + ((Col % RASTER_WIDTH) + RASTER_WIDTH) % RASTER_WIDTH];
+            if (ID >= 0 && std::find(Candidates.begin(), Candidates.end(), ID) == Candidates.end())
+            {
+                Candidates.emplace_back(ID);
+            }
+        }
+    }
+}
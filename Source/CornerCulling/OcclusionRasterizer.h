@@ -0,0 +1,53 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GeometricPrimitives.h"
+#include <vector>
+
+// Resolution of the latitude-longitude buffer.
+// Width must be a multiple of 8 so that rows split into AVX lanes.
+constexpr int RASTER_WIDTH = 64;
+constexpr int RASTER_HEIGHT = 32;
+constexpr int RASTER_PIXELS = RASTER_WIDTH * RASTER_HEIGHT;
+
+// Low-resolution depth and ID buffer of the cuboids around a player,
+// covering every direction from the center of the player's peeks.
+// Cuboids are rasterized by casting the ray through each pixel center within
+// their angular bounds, eight pixels at a time, and keeping the nearest hit.
+// A cuboid that blocks every peek of a bundle blocks the center of the peek
+// box too, as the center lies between the peeks, so it covers the enemy's
+// pixels. The IDs in
+// those pixels are therefore candidate occluders, which are confirmed with
+// IsBlocking. Occluders hidden behind nearer, partial occluders are missed,
+// so the rasterizer may cull less than the BVH but never culls wrongly.
+class OcclusionRasterizer
+{
+    // Unit directions of the rays through the center of each pixel.
+    float DirectionXs[RASTER_PIXELS];
+    float DirectionYs[RASTER_PIXELS];
+    float DirectionZs[RASTER_PIXELS];
+    // Distance to the nearest cuboid in each pixel.
+    float Depths[RASTER_PIXELS];
+    // ID of the nearest cuboid in each pixel, or -1 if none.
+    int IDs[RASTER_PIXELS];
+    FVector Origin;
+
+    // Gets the pixel rectangle spanned by the directions to points.
+    // Columns may fall outside of the buffer and wrap around.
+    void GetRect(
+        const FVector* Points,
+        int Count,
+        int& Col0,
+        int& Col1,
+        int& Row0,
+        int& Row1) const;
+
+public:
+    OcclusionRasterizer();
+    // Empties the buffer and centers it on a new origin.
+    void Clear(const FVector& NewOrigin);
+    // Rasterizes a cuboid, keeping the nearest cuboid in each pixel.
+    void Rasterize(const Cuboid* C, int ID);
+    // Appends the distinct IDs of cuboids in the pixels of a character.
+    void GetCandidates(const CharacterBounds& Bounds, std::vector<int>& Candidates) const;
+};
@@ -0,0 +1,39 @@
+#include "PVSVolume.h"
+#include "OccludingCuboid.h"
+#include "EngineUtils.h"
+#include "Misc/Paths.h"
+
+APVSVolume::APVSVolume()
+    : Super()
+{
+    PrimaryActorTick.bCanEverTick = false;
+    RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+}
+
+PVSSettings APVSVolume::GetSettings() const
+{
+    PVSSettings Settings;
+    Settings.Bounds = FBox::BuildAABB(GetActorLocation(), Extent);
+    Settings.CellSize = CellSize;
+    Settings.RegionSize = RegionSize;
+    Settings.MarginHorizontal = MarginHorizontal;
+    Settings.MarginVertical = MarginVertical;
+    Settings.Directory = FPaths::Combine(
+        FPaths::ProjectSavedDir(),
+        TEXT("PVS"),
+        UWorld::RemovePIEPrefix(GetWorld()->GetMapName()));
+    return Settings;
+}
+
+void APVSVolume::BuildPVS()
+{
+    std::vector<Cuboid> Cuboids;
+    for (AOccludingCuboid* C : TActorRange<AOccludingCuboid>(GetWorld()))
+    {
+        C->Update();
+        Cuboids.emplace_back(Cuboid(C->Vertices));
+    }
+    PotentiallyVisibleSet PVS;
+    int Rebuilt = PVS.Build(GetSettings(), Cuboids);
+    UE_LOG(LogCulling, Log, TEXT("Rebuilt %d PVS regions for %s."), Rebuilt, *GetName());
+}
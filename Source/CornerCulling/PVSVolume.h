@@ -0,0 +1,38 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "PotentiallyVisibleSet.h"
+#include "PVSVolume.generated.h"
+
+// Box-shaped volume over which a potentially visible set is precomputed.
+// Place one in a static map and build its PVS from the details panel.
+// Region files are stored under Saved/PVS/<map name>.
+UCLASS(BlueprintType, Blueprintable)
+class APVSVolume : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	APVSVolume();
+	// Half of the size of the axis-aligned volume.
+	UPROPERTY(EditAnywhere)
+	FVector Extent = FVector(5000, 5000, 1000);
+	// Side length of each cubic cell.
+	UPROPERTY(EditAnywhere)
+	float CellSize = 200;
+	// Number of cells along each side of a separately stored region.
+	UPROPERTY(EditAnywhere)
+	int RegionSize = 8;
+	// Margins by which cells are expanded. See PVSSettings.
+	UPROPERTY(EditAnywhere)
+	float MarginHorizontal = 100;
+	UPROPERTY(EditAnywhere)
+	float MarginVertical = 120;
+
+	// Gets the settings of the PVS of this volume.
+	PVSSettings GetSettings() const;
+	// Builds regions of the PVS that are missing or out of date.
+	UFUNCTION(CallInEditor)
+	void BuildPVS();
+};
@@ -0,0 +1,274 @@
+#include "PotentiallyVisibleSet.h"
+#include "FastBVH.h"
+#include "OccluderSimplification.h"
+#include "Async/ParallelFor.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogPVS, Log, All);
+
+// Identifies region files and their format version.
+constexpr uint32 PVS_MAGIC = 0x31535650;
+
+// Checks if a cuboid blocks every line of sight between two axis-aligned boxes.
+// The top corners of each box lie directly above its bottom corners, so,
+// as with IsBlocking, it suffices to test top corners against top corners
+// and bottom corners against bottom corners.
+static bool BlocksBoxes(const Cuboid* C, const FBox& A, const FBox& B)
+{
+    for (int Top = 0; Top < 2; Top++)
+    {
+        float AZ = Top ? A.Max.Z : A.Min.Z;
+        float BZ = Top ? B.Max.Z : B.Min.Z;
+        __m256 EndXs = _mm256_set_ps(
+            B.Min.X, B.Min.X, B.Max.X, B.Max.X,
+            B.Min.X, B.Min.X, B.Max.X, B.Max.X);
+        __m256 EndYs = _mm256_set_ps(
+            B.Min.Y, B.Max.Y, B.Min.Y, B.Max.Y,
+            B.Min.Y, B.Max.Y, B.Min.Y, B.Max.Y);
+        __m256 EndZs = _mm256_set1_ps(BZ);
+        __m256 StartZs = _mm256_set1_ps(AZ);
+        // Each pass tests two corners of A against four corners of B.
+        for (int Half = 0; Half < 2; Half++)
+        {
+            float AX = Half ? A.Max.X : A.Min.X;
+            __m256 StartXs = _mm256_set1_ps(AX);
+            __m256 StartYs = _mm256_set_ps(
+                A.Min.Y, A.Min.Y, A.Min.Y, A.Min.Y,
+                A.Max.Y, A.Max.Y, A.Max.Y, A.Max.Y);
+            if (!IntersectsAll(C, StartXs, StartYs, StartZs, EndXs, EndYs, EndZs))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Hashes the geometry and settings that a region was built from.
+// Cuboids are summed so that the hash does not depend on their order.
+static uint32 GetHash(const PVSSettings& Settings, const std::vector<Cuboid>& Cuboids)
+{
+    // FBox has padding after IsValid, so hash its fields separately.
+    uint32 Hash = FCrc::MemCrc32(&Settings.Bounds.Min, sizeof(FVector));
+    Hash = FCrc::MemCrc32(&Settings.Bounds.Max, sizeof(FVector), Hash);
+    Hash = FCrc::MemCrc32(&Settings.Bounds.IsValid, sizeof(Settings.Bounds.IsValid), Hash);
+    Hash = FCrc::MemCrc32(&Settings.CellSize, sizeof(float), Hash);
+    Hash = FCrc::MemCrc32(&Settings.RegionSize, sizeof(int), Hash);
+    Hash = FCrc::MemCrc32(&Settings.MarginHorizontal, sizeof(float), Hash);
+    Hash = FCrc::MemCrc32(&Settings.MarginVertical, sizeof(float), Hash);
+    uint32 CuboidSum = 0;
+    for (const Cuboid& C : Cuboids)
+    {
+        CuboidSum += FCrc::MemCrc32(C.Vertices, sizeof(C.Vertices));
+    }
+    return FCrc::MemCrc32(&CuboidSum, sizeof(uint32), Hash);
+}
+
+void PotentiallyVisibleSet::SetGrid(const PVSSettings& Settings)
+{
+    Origin = Settings.Bounds.Min;
+    CellSize = Settings.CellSize;
+    FVector Size = Settings.Bounds.GetSize();
+    for (int k = 0; k < 3; k++)
+    {
+        Dims[k] = std::max(1, FMath::CeilToInt(Size[k] / CellSize));
+    }
+    Margin = FVector(Settings.MarginHorizontal, Settings.MarginHorizontal, Settings.MarginVertical);
+}
+
+FString PotentiallyVisibleSet::RegionPath(const FString& Directory, int Region) const
+{
+    return FPaths::Combine(Directory, FString::Printf(TEXT("Region%d.pvs"), Region));
+}
+
+FBox PotentiallyVisibleSet::GetCellBox(int Cell) const
+{
+    int X = Cell % Dims[0];
+    int Y = (Cell / Dims[0]) % Dims[1];
+    int Z = Cell / (Dims[0] * Dims[1]);
+    FVector Min = Origin + CellSize * FVector(X, Y, Z);
+    return FBox(Min - Margin, Min + FVector(CellSize) + Margin);
+}
+
+int PotentiallyVisibleSet::FindCell(const FVector& Point) const
+{
+    int Coords[3];
+    for (int k = 0; k < 3; k++)
+    {
+        Coords[k] = FMath::FloorToInt((Point[k] - Origin[k]) / CellSize);
+        if (Coords[k] < 0 || Coords[k] >= Dims[k])
+        {
+            return -1;
+        }
+    }
+    return Coords[0] + Dims[0] * (Coords[1] + Dims[1] * Coords[2]);
+}
+
+bool PotentiallyVisibleSet::CanSee(int A, int B) const
+{
+    const std::vector<uint32>& Row = Rows[A];
+    // Visibility flips once at every column up to and including B.
+    int Flips = std::upper_bound(Row.begin(), Row.end(), uint32(B)) - Row.begin();
+    return (Flips % 2) == 1;
+}
+
+int PotentiallyVisibleSet::Build(const PVSSettings& Settings, const std::vector<Cuboid>& Cuboids)
+{
+    SetGrid(Settings);
+    Rows.assign(NumCells(), std::vector<uint32>());
+    uint32 Hash = GetHash(Settings, Cuboids);
+    // Simplification and the BVH builder modify the cuboids, so work on a copy.
+    std::vector<Cuboid> BVHCuboids = Cuboids;
+    SimplifyCuboids(BVHCuboids);
+    std::unique_ptr<FastBVH::BVH<float, Cuboid>> CuboidBVH;
+    CuboidIntersector Intersector;
+    std::unique_ptr<Traverser<float, CuboidIntersector>> CuboidTraverser;
+    if (BVHCuboids.size() > 0)
+    {
+        FastBVH::BuildStrategy<float, 1> Builder;
+        CuboidBoxConverter Converter;
+        CuboidBVH = std::make_unique
+            <FastBVH::BVH<float, Cuboid>>
+            (Builder(BVHCuboids, Converter));
+        CuboidTraverser = std::make_unique
+            <Traverser<float, CuboidIntersector>>
+            (*CuboidBVH.get(), Intersector);
+    }
+    int RegionDims[3];
+    for (int k = 0; k < 3; k++)
+    {
+        RegionDims[k] = (Dims[k] + Settings.RegionSize - 1) / Settings.RegionSize;
+    }
+    int NumRegions = RegionDims[0] * RegionDims[1] * RegionDims[2];
+    int Rebuilt = 0;
+    for (int Region = 0; Region < NumRegions; Region++)
+    {
+        int RX = Region % RegionDims[0];
+        int RY = (Region / RegionDims[0]) % RegionDims[1];
+        int RZ = Region / (RegionDims[0] * RegionDims[1]);
+        std::vector<int> RegionCells;
+        for (int Z = RZ * Settings.RegionSize; Z < std::min(Dims[2], (RZ + 1) * Settings.RegionSize); Z++)
+        {
+            for (int Y = RY * Settings.RegionSize; Y < std::min(Dims[1], (RY + 1) * Settings.RegionSize); Y++)
+            {
+                for (int X = RX * Settings.RegionSize; X < std::min(Dims[0], (RX + 1) * Settings.RegionSize); X++)
+                {
+                    RegionCells.emplace_back(X + Dims[0] * (Y + Dims[1] * Z));
+                }
+            }
+        }
+        // Skip regions that are already up to date.
+        TArray<uint8> Data;
+        if (FFileHelper::LoadFileToArray(Data, *RegionPath(Settings.Directory, Region), FILEREAD_Silent))
+        {
+            FMemoryReader Reader(Data);
+            uint32 Magic, FileHash;
+            int32 FileRegion;
+            Reader << Magic << FileHash << FileRegion;
+            if (Magic == PVS_MAGIC && FileHash == Hash && FileRegion == Region)
+            {
+                continue;
+            }
+        }
+        ParallelFor(RegionCells.size(), [&](int32 k)
+        {
+            int A = RegionCells[k];
+            FBox BoxA = GetCellBox(A);
+            std::vector<uint32>& Row = Rows[A];
+            bool WasVisible = false;
+            for (int B = 0; B < NumCells(); B++)
+            {
+                FBox BoxB = GetCellBox(B);
+                bool Visible = true;
+                if (CuboidTraverser && !BoxA.Intersect(BoxB))
+                {
+                    const Cuboid* Blocker = CuboidTraverser->traverse(
+                        OptSegment(BoxA.GetCenter(), BoxB.GetCenter()),
+                        [&](const Cuboid* C) { return BlocksBoxes(C, BoxA, BoxB) ? C : NULL; });
+                    Visible = (Blocker == NULL);
+                }
+                if (Visible != WasVisible)
+                {
+                    Row.emplace_back(B);
+                    WasVisible = Visible;
+                }
+            }
+        });
+        Data.Reset();
+        FMemoryWriter Writer(Data);
+        uint32 Magic = PVS_MAGIC;
+        int32 FileRegion = Region;
+        Writer << Magic << Hash << FileRegion;
+        for (int A : RegionCells)
+        {
+            uint32 Count = Rows[A].size();
+            Writer << Count;
+            for (uint32 Column : Rows[A])
+            {
+                Writer << Column;
+            }
+        }
+        FFileHelper::SaveArrayToFile(Data, *RegionPath(Settings.Directory, Region));
+        Rebuilt++;
+        UE_LOG(LogPVS, Log, TEXT("Built PVS region %d of %d."), Region + 1, NumRegions);
+    }
+    // Regions that were up to date were skipped, so load the full set.
+    Load(Settings, Cuboids);
+    return Rebuilt;
+}
+
+bool PotentiallyVisibleSet::Load(const PVSSettings& Settings, const std::vector<Cuboid>& Cuboids)
+{
+    SetGrid(Settings);
+    Rows.assign(NumCells(), std::vector<uint32>());
+    uint32 Hash = GetHash(Settings, Cuboids);
+    int RegionDims[3];
+    for (int k = 0; k < 3; k++)
+    {
+        RegionDims[k] = (Dims[k] + Settings.RegionSize - 1) / Settings.RegionSize;
+    }
+    int NumRegions = RegionDims[0] * RegionDims[1] * RegionDims[2];
+    for (int Region = 0; Region < NumRegions; Region++)
+    {
+        TArray<uint8> Data;
+        if (!FFileHelper::LoadFileToArray(Data, *RegionPath(Settings.Directory, Region), FILEREAD_Silent))
+        {
+            Rows.clear();
+            return false;
+        }
+        FMemoryReader Reader(Data);
+        uint32 Magic, FileHash;
+        int32 FileRegion;
+        Reader << Magic << FileHash << FileRegion;
+        if (Magic != PVS_MAGIC || FileHash != Hash || FileRegion != Region)
+        {
+            UE_LOG(LogPVS, Warning, TEXT("PVS region %d is out of date."), Region);
+            Rows.clear();
+            return false;
+        }
+        int RX = Region % RegionDims[0];
+        int RY = (Region / RegionDims[0]) % RegionDims[1];
+        int RZ = Region / (RegionDims[0] * RegionDims[1]);
+        for (int Z = RZ * Settings.RegionSize; Z < std::min(Dims[2], (RZ + 1) * Settings.RegionSize); Z++)
+        {
+            for (int Y = RY * Settings.RegionSize; Y < std::min(Dims[1], (RY + 1) * Settings.RegionSize); Y++)
+            {
+                for (int X = RX * Settings.RegionSize; X < std::min(Dims[0], (RX + 1) * Settings.RegionSize); X++)
+                {
+                    std::vector<uint32>& Row = Rows[X + Dims[0] * (Y + Dims[1] * Z)];
+                    uint32 Count;
+                    Reader << Count;
+                    Row.resize(Count);
+                    for (uint32& Column : Row)
+                    {
+                        Reader << Column;
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
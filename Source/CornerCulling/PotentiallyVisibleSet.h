@@ -0,0 +1,74 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GeometricPrimitives.h"
+#include <vector>
+
+// Settings of an offline potentially visible set (PVS) build.
+struct PVSSettings
+{
+    // Playable space that is divided into cells.
+    FBox Bounds;
+    // Side length of each cubic cell.
+    float CellSize = 200;
+    // Number of cells along each side of a region. Each region is built and
+    // stored separately, so an interrupted build resumes where it stopped.
+    int RegionSize = 8;
+    // Each cell is expanded by this margin before testing visibility.
+    // Must cover both the largest peek of a player and the distance from
+    // an enemy's center to the edges of its bounding box.
+    // The horizontal default covers a player running at the default maximum
+    // walk speed of 600 for the default PeekTimeBudget of 0.15 seconds.
+    // Players whose peeks are larger, such as those with high latency,
+    // are not culled with the PVS.
+    float MarginHorizontal = 100;
+    float MarginVertical = 120;
+    // Directory in which region files are stored.
+    FString Directory;
+};
+
+// Cell-to-cell potentially visible set of a static map, precomputed offline.
+// Each cell is tested against every other cell with the same BVH and
+// Cyrus-Beck machinery as the runtime culler, so two cells are marked
+// invisible only if a single cuboid blocks every line of sight between them.
+// Rows are stored as the sorted columns at which visibility flips,
+// which compresses the long runs of nearby visible and distant invisible cells.
+class PotentiallyVisibleSet
+{
+    FVector Origin;
+    float CellSize = 0;
+    int Dims[3] = { 0, 0, 0 };
+    FVector Margin;
+    // Visibility of each row starts as invisible and flips at each column.
+    std::vector<std::vector<uint32>> Rows;
+
+    int NumCells() const
+    {
+        return Dims[0] * Dims[1] * Dims[2];
+    }
+    FString RegionPath(const FString& Directory, int Region) const;
+    // Gets the cell-expanded box used to test visibility.
+    FBox GetCellBox(int Cell) const;
+    void SetGrid(const PVSSettings& Settings);
+
+public:
+    // Builds every region of the PVS that is missing or was built from
+    // different geometry or settings. Rows within a region are built in
+    // parallel. Returns the number of regions that were rebuilt.
+    int Build(const PVSSettings& Settings, const std::vector<Cuboid>& Cuboids);
+    // Loads every region of a PVS. Returns false if any region is missing.
+    bool Load(const PVSSettings& Settings, const std::vector<Cuboid>& Cuboids);
+    bool IsLoaded() const
+    {
+        return Rows.size() > 0 && Rows.size() == NumCells();
+    }
+    // Checks if the PVS accounts for peeks and enemies of these sizes.
+    bool CoversMargin(float Horizontal, float Vertical) const
+    {
+        return Horizontal <= Margin.X && Vertical <= Margin.Z;
+    }
+    // Gets the index of the cell containing a point, or -1 if it is outside.
+    int FindCell(const FVector& Point) const;
+    // Checks if any point in cell B may be visible from cell A.
+    bool CanSee(int A, int B) const;
+};
@@ -0,0 +1,118 @@
+#include "ShadowVolume.h"
+
+// Vertex indices of the twelve edges of a cuboid.
+constexpr char CuboidEdgeMap[12][2] =
+{
+    { 0, 1 }, { 1, 2 }, { 2, 3 }, { 3, 0 },
+    { 4, 5 }, { 5, 6 }, { 6, 7 }, { 7, 4 },
+    { 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 }
+};
+
+// Distance within which cuboid vertices are considered to lie on a plane.
+constexpr float PLANE_TOLERANCE = 1e-2f;
+
+void ShadowVolume::AddPlane(const FVector& Normal, const FVector& Point)
+{
+    NormalXs.emplace_back(Normal.X);
+    NormalYs.emplace_back(Normal.Y);
+    NormalZs.emplace_back(Normal.Z);
+    Offsets.emplace_back(Normal | Point);
+}
+
+bool ShadowVolume::Build(const Cuboid* C, const FBox& Source)
+{
+    Occluder = C;
+    NormalXs.clear();
+    NormalYs.clear();
+    NormalZs.clear();
+    Offsets.clear();
+    FVector SourceVertices[CUBOID_V];
+    for (int i = 0; i < CUBOID_V; i++)
+    {
+        SourceVertices[i] = FVector(
+            (i & 1) ? Source.Max.X : Source.Min.X,
+            (i & 2) ? Source.Max.Y : Source.Min.Y,
+            (i & 4) ? Source.Max.Z : Source.Min.Z);
+    }
+    // The shadow lies behind every face that some source vertex is in front of.
+    // Test these planes first, as they reject most enemies.
+    for (int f = 0; f < CUBOID_F; f++)
+    {
+        const FVector& Normal = C->Faces[f].Normal;
+        const FVector& FaceVertex = C->GetVertex(f, 0);
+        for (int i = 0; i < CUBOID_V; i++)
+        {
+            if ((Normal | (SourceVertices[i] - FaceVertex)) > 0)
+            {
+                AddPlane(Normal, FaceVertex);
+                break;
+            }
+        }
+    }
+    // A source vertex behind every face is inside the cuboid.
+    for (int i = 0; i < CUBOID_V; i++)
+    {
+        bool Inside = true;
+        for (int f = 0; f < CUBOID_F && Inside; f++)
+        {
+            Inside = (C->Faces[f].Normal | (SourceVertices[i] - C->GetVertex(f, 0))) <= 0;
+        }
+        if (Inside)
+        {
+            return false;
+        }
+    }
+    // Planes through a source vertex and a silhouette edge of the cuboid.
+    for (int i = 0; i < CUBOID_V; i++)
+    {
+        const FVector& S = SourceVertices[i];
+        for (int e = 0; e < 12; e++)
+        {
+            const FVector& A = C->Vertices[CuboidEdgeMap[e][0]];
+            const FVector& B = C->Vertices[CuboidEdgeMap[e][1]];
+            FVector Normal = ((A - S) ^ (B - S)).GetSafeNormal();
+            if (Normal.IsZero())
+            {
+                continue;
+            }
+            // The edge is on the silhouette if the cuboid lies on one side.
+            bool AllBelow = true;
+            bool AllAbove = true;
+            for (int k = 0; k < CUBOID_V; k++)
+            {
+                float Distance = Normal | (C->Vertices[k] - S);
+                AllBelow &= Distance <= PLANE_TOLERANCE;
+                AllAbove &= Distance >= -PLANE_TOLERANCE;
+            }
+            if (AllBelow)
+            {
+                AddPlane(Normal, S);
+            }
+            else if (AllAbove)
+            {
+                AddPlane(-Normal, S);
+            }
+        }
+    }
+    return true;
+}
+
+bool ShadowVolume::MayContain(__m256 Xs, __m256 Ys, __m256 Zs) const
+{
+    __m256 Zero = _mm256_setzero_ps();
+    for (int p = 0; p < NumPlanes(); p++)
+    {
+        __m256 Distances = _mm256_sub_ps(
+            _mm256_add_ps(
+                _mm256_add_ps(
+                    _mm256_mul_ps(Xs, _mm256_set1_ps(NormalXs[p])),
+                    _mm256_mul_ps(Ys, _mm256_set1_ps(NormalYs[p]))),
+                _mm256_mul_ps(Zs, _mm256_set1_ps(NormalZs[p]))),
+            _mm256_set1_ps(Offsets[p]));
+        if (_mm256_movemask_ps(_mm256_cmp_ps(Distances, Zero, _CMP_GT_OQ)) != 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
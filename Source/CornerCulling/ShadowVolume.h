@@ -0,0 +1,39 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GeometricPrimitives.h"
+#include <vector>
+
+// Conservative shadow volume of a cuboid lit by an axis-aligned box
+// containing all of a player's possible peeks.
+// A point is hidden from the whole box only if it is hidden from each
+// vertex of the box, and the shadow of a cuboid from a single point is
+// bounded by the cuboid's front faces and by planes through the point
+// and the cuboid's silhouette edges. The shadow volume keeps these planes,
+// so every point that the cuboid hides from the whole box lies inside it.
+// The planes are only a filter: an enemy inside them is confirmed
+// with IsBlocking before being culled.
+struct ShadowVolume
+{
+    const Cuboid* Occluder = NULL;
+    // Planes with the shadow on their negative side.
+    // Stored as components for SIMD tests of eight vertices at a time.
+    std::vector<float> NormalXs;
+    std::vector<float> NormalYs;
+    std::vector<float> NormalZs;
+    std::vector<float> Offsets;
+
+    // Builds the shadow volume of C lit by Source.
+    // Returns false if Source overlaps C, which then casts no shadow.
+    bool Build(const Cuboid* C, const FBox& Source);
+    // Checks if all eight vertices, packed into SIMD registers,
+    // may lie inside the shadow volume.
+    bool MayContain(__m256 Xs, __m256 Ys, __m256 Zs) const;
+    int NumPlanes() const
+    {
+        return Offsets.size();
+    }
+
+private:
+    void AddPlane(const FVector& Normal, const FVector& Point);
+};
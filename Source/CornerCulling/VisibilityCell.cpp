@@ -0,0 +1,64 @@
+#include "VisibilityCell.h"
+
+AVisibilityCell::AVisibilityCell()
+    : Super()
+{
+    PrimaryActorTick.bCanEverTick = true;
+    PrimaryActorTick.bStartWithTickEnabled = true;
+}
+
+void AVisibilityCell::DrawEdges(bool Persist = false)
+{
+    UWorld* World = GetWorld();
+    for (int i = 0; i < CUBOID_F; i++)
+    {
+        for (int j = 0; j < CUBOID_FACE_V; j++)
+        {
+            ACullingController::ConnectVectors(
+                World,
+                Volume.GetVertex(i, j),
+                Volume.GetVertex(i, (j + 1) % CUBOID_FACE_V),
+                Persist,
+                1 + (DrawPeriod / 120.0f),
+                2,
+                FColor::Cyan);
+        }
+    }
+}
+
+void AVisibilityCell::BeginPlay()
+{
+    Super::BeginPlay();
+    SetActorTickEnabled(false);
+    Update();
+    if (DrawEdgesInGame)
+        DrawEdges(true);
+}
+
+void AVisibilityCell::Tick(float DeltaTime)
+{
+    Super::Tick(DeltaTime);
+    TickCount++;
+    if ((TickCount % DrawPeriod) == 0)
+    {
+        Update();
+        DrawEdges(false);
+    }
+}
+
+void AVisibilityCell::Update()
+{
+    FTransform T = GetTransform();
+    TArray<FVector> Vertices;
+    Vertices.Emplace(T.TransformPosition(FVector(Extent.X, Extent.Y, Extent.Z)));
+    Vertices.Emplace(T.TransformPosition(FVector(-Extent.X, Extent.Y, Extent.Z)));
+    Vertices.Emplace(T.TransformPosition(FVector(-Extent.X, -Extent.Y, Extent.Z)));
+    Vertices.Emplace(T.TransformPosition(FVector(Extent.X, -Extent.Y, Extent.Z)));
+    Vertices.Emplace(T.TransformPosition(FVector(Extent.X, Extent.Y, -Extent.Z)));
+    Vertices.Emplace(T.TransformPosition(FVector(-Extent.X, Extent.Y, -Extent.Z)));
+    Vertices.Emplace(T.TransformPosition(FVector(-Extent.X, -Extent.Y, -Extent.Z)));
+    Vertices.Emplace(T.TransformPosition(FVector(Extent.X, -Extent.Y, -Extent.Z)));
+    Volume = Cuboid(Vertices);
+}
+
+bool AVisibilityCell::ShouldTickIfViewportsOnly() const { return true; }
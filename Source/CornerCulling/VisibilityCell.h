@@ -0,0 +1,40 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CullingController.h"
+#include "GeometricPrimitives.h"
+#include "VisibilityCell.generated.h"
+
+// Box-shaped region of an indoor map, such as a room or corridor.
+// Cells are connected by portals, and lines of sight between cells may only
+// pass through portals. Cells should not overlap.
+UCLASS(BlueprintType, Blueprintable)
+class AVisibilityCell : public AActor
+{
+	GENERATED_BODY()
+
+	// Counts ticks to not draw every tick.
+	int TickCount = 0;
+	// Frames between draw calls.
+	int DrawPeriod = 60;
+
+public:
+	AVisibilityCell();
+	// Half of the size of the cell along each local axis.
+	UPROPERTY(EditAnywhere)
+	FVector Extent = FVector(500, 500, 200);
+	UPROPERTY(EditAnywhere)
+	bool DrawEdgesInGame = false;
+	// The volume of the cell in world space.
+	Cuboid Volume;
+
+	// Updates the Volume according to the transform and extent.
+	void Update();
+	// Draw the edges of the Volume in the level editor.
+	void DrawEdges(bool Persist);
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual bool ShouldTickIfViewportsOnly() const override;
+};
@@ -0,0 +1,55 @@
+#include "VisibilityPortal.h"
+
+AVisibilityPortal::AVisibilityPortal()
+    : Super()
+{
+    PrimaryActorTick.bCanEverTick = true;
+    PrimaryActorTick.bStartWithTickEnabled = true;
+}
+
+void AVisibilityPortal::DrawEdges(bool Persist = false)
+{
+    UWorld* World = GetWorld();
+    for (int i = 0; i < 4; i++)
+    {
+        ACullingController::ConnectVectors(
+            World,
+            Corners[i],
+            Corners[(i + 1) % 4],
+            Persist,
+            1 + (DrawPeriod / 120.0f),
+            3,
+            FColor::Orange);
+    }
+}
+
+void AVisibilityPortal::BeginPlay()
+{
+    Super::BeginPlay();
+    SetActorTickEnabled(false);
+    Update();
+    if (DrawEdgesInGame)
+        DrawEdges(true);
+}
+
+void AVisibilityPortal::Tick(float DeltaTime)
+{
+    Super::Tick(DeltaTime);
+    TickCount++;
+    if ((TickCount % DrawPeriod) == 0)
+    {
+        Update();
+        DrawEdges(false);
+    }
+}
+
+void AVisibilityPortal::Update()
+{
+    FTransform T = GetTransform();
+    Corners[0] = T.TransformPosition(FVector(0, Extent.X, Extent.Y));
+    Corners[1] = T.TransformPosition(FVector(0, -Extent.X, Extent.Y));
+    Corners[2] = T.TransformPosition(FVector(0, -Extent.X, -Extent.Y));
+    Corners[3] = T.TransformPosition(FVector(0, Extent.X, -Extent.Y));
+}
+
+bool AVisibilityPortal::ShouldTickIfViewportsOnly() const { return true; }
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CullingController.h"
+#include "VisibilityCell.h"
+#include "VisibilityPortal.generated.h"
+
+// Rectangular opening, such as a door or window, between two cells.
+// The rectangle lies in the actor's local YZ plane.
+UCLASS(BlueprintType, Blueprintable)
+class AVisibilityPortal : public AActor
+{
+	GENERATED_BODY()
+
+	// Counts ticks to not draw every tick.
+	int TickCount = 0;
+	// Frames between draw calls.
+	int DrawPeriod = 60;
+
+public:
+	AVisibilityPortal();
+	// Half of the width and height of the opening.
+	UPROPERTY(EditAnywhere)
+	FVector2D Extent = FVector2D(100, 120);
+	// The cells that the portal connects.
+	UPROPERTY(EditAnywhere)
+	AVisibilityCell* CellA = NULL;
+	UPROPERTY(EditAnywhere)
+	AVisibilityCell* CellB = NULL;
+	UPROPERTY(EditAnywhere)
+	bool DrawEdgesInGame = false;
+	// Corners of the opening in world space, in perimeter order.
+	FVector Corners[4];
+
+	// Updates the Corners according to the transform and extent.
+	void Update();
+	// Draw the edges of the opening in the level editor.
+	void DrawEdges(bool Persist);
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual bool ShouldTickIfViewportsOnly() const override;
+};
@@ -0,0 +1,154 @@
+#include "WallSweep.h"
+
+// Horizontal distance within which top vertices count as above bottom vertices.
+constexpr float PRISM_TOLERANCE = 1e-2f;
+
+bool Wall::FromCuboid(const Cuboid* C, float ZMin, float ZMax)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        const FVector& Top = C->Vertices[i];
+        const FVector& Bottom = C->Vertices[i + 4];
+        if (Top.Z < ZMax
+            || Bottom.Z > ZMin
+            || FVector2D::Distance(FVector2D(Top), FVector2D(Bottom)) > PRISM_TOLERANCE)
+        {
+            return false;
+        }
+        Corners[i] = FVector2D(Top);
+    }
+    float Area = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        Area += Corners[i] ^ Corners[(i + 1) % 4];
+    }
+    if (FMath::Abs(Area) < PRISM_TOLERANCE)
+    {
+        return false;
+    }
+    if (Area < 0)
+    {
+        std::swap(Corners[1], Corners[3]);
+    }
+    for (int i = 0; i < 4; i++)
+    {
+        FVector2D Edge = Corners[(i + 1) % 4] - Corners[i];
+        Normals[i] = FVector2D(Edge.Y, -Edge.X).GetSafeNormal();
+    }
+    Occluder = C;
+    return true;
+}
+
+float Wall::EnterTime(const FVector2D& Start, const FVector2D& Delta, float MaxTime) const
+{
+    float EnterTime = 0;
+    float ExitTime = MaxTime;
+    for (int i = 0; i < 4; i++)
+    {
+        float Num = Normals[i] | (Corners[i] - Start);
+        float Denom = Normals[i] | Delta;
+        if (Denom == 0)
+        {
+            if (Num < 0)
+            {
+                return -1;
+            }
+        }
+        else if (Denom < 0)
+        {
+            EnterTime = std::max(EnterTime, Num / Denom);
+        }
+        else
+        {
+            ExitTime = std::min(ExitTime, Num / Denom);
+        }
+        if (EnterTime > ExitTime)
+        {
+            return -1;
+        }
+    }
+    return EnterTime;
+}
+
+bool Wall::Blocks(const FVector2D* Starts, int NumStarts, const FVector2D* Ends, int NumEnds) const
+{
+    for (int i = 0; i < NumStarts; i++)
+    {
+        for (int j = 0; j < NumEnds; j++)
+        {
+            if (EnterTime(Starts[i], Ends[j] - Starts[i], 1) < 0)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void WallSweep::Clear(const FVector2D& NewOrigin)
+{
+    Origin = NewOrigin;
+    std::fill(Depths, Depths + SWEEP_BINS, std::numeric_limits<float>::infinity());
+    std::fill(IDs, IDs + SWEEP_BINS, -1);
+}
+
+void WallSweep::GetBins(const FVector2D* Points, int Count, int& Bin0, int& Bin1) const
+{
+    FVector2D Mean = FVector2D::ZeroVector;
+    for (int i = 0; i < Count; i++)
+    {
+        Mean += Points[i];
+    }
+    Mean = Mean / Count - Origin;
+    // Measure angles relative to the mean so that the range does not wrap.
+    float MeanAngle = FMath::Atan2(Mean.Y, Mean.X);
+    float MinAngle = 0, MaxAngle = 0;
+    for (int i = 0; i < Count; i++)
+    {
+        FVector2D D = Points[i] - Origin;
+        float Angle = FMath::UnwindRadians(FMath::Atan2(D.Y, D.X) - MeanAngle);
+        MinAngle = std::min(MinAngle, Angle);
+        MaxAngle = std::max(MaxAngle, Angle);
+    }
+    float Scale = SWEEP_BINS / (2 * PI);
+    Bin0 = FMath::FloorToInt((MeanAngle + MinAngle + PI) * Scale);
+    Bin1 = FMath::FloorToInt((MeanAngle + MaxAngle + PI) * Scale);
+    Bin1 = std::min(Bin1, Bin0 + SWEEP_BINS - 1);
+}
+
+void WallSweep::Insert(const Wall& W, int ID)
+{
+    int Bin0, Bin1;
+    GetBins(W.Corners, 4, Bin0, Bin1);
+    for (int Bin = Bin0; Bin <= Bin1; Bin++)
+    {
+        int Index = ((Bin % SWEEP_BINS) + SWEEP_BINS) % SWEEP_BINS;
+        float Angle = 2 * PI * ((Index + 0.5f) / SWEEP_BINS - 0.5f);
+        float Depth = W.EnterTime(
+            Origin,
+            FVector2D(FMath::Cos(Angle), FMath::Sin(Angle)),
+            std::numeric_limits<float>::infinity());
+        if (Depth > 0 && Depth < Depths[Index])
+        {
+            Depths[Index] = Depth;
+            IDs[Index] = ID;
+        }
+    }
+}
+
+void WallSweep::GetCandidates(
+    const FVector2D* Points,
+    int Count,
+    std::vector<int>& Candidates) const
+{
+    int Bin0, Bin1;
+    GetBins(Points, Count, Bin0, Bin1);
+    for (int Bin = Bin0; Bin <= Bin1; Bin++)
+    {
+        int ID = IDs[((Bin % SWEEP_BINS) + SWEEP_BINS) % SWEEP_BINS];
+        if (ID >= 0 && std::find(Candidates.begin(), Candidates.end(), ID) == Candidates.end())
+        {
+            Candidates.emplace_back(ID);
+        }
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GeometricPrimitives.h"
+#include <vector>
+
+// Number of angular bins around each player.
+constexpr int SWEEP_BINS = 256;
+
+// Cuboid that is a vertical prism spanning the whole playable band of
+// heights, such as a floor-to-ceiling wall. Within the band, its cross
+// section is the same convex footprint at every height, so it blocks a line
+// of sight in the band exactly when its footprint blocks the line's shadow
+// on the XY plane.
+struct Wall
+{
+    const Cuboid* Occluder = NULL;
+    // Corners of the footprint, counter-clockwise.
+    FVector2D Corners[4];
+    // Outward normals of the footprint's edges. Edge i runs from corner i.
+    FVector2D Normals[4];
+
+    // Converts a cuboid into a wall, returning false if it is not a vertical
+    // prism that spans heights from ZMin to ZMax.
+    bool FromCuboid(const Cuboid* C, float ZMin, float ZMax);
+    // Gets the time at which a ray or segment from Start along Delta enters
+    // the footprint, or a negative value if it misses.
+    float EnterTime(const FVector2D& Start, const FVector2D& Delta, float MaxTime) const;
+    // Checks if the footprint blocks every segment from Starts to Ends.
+    // As the footprint is convex, this blocks their convex hulls too.
+    bool Blocks(const FVector2D* Starts, int NumStarts, const FVector2D* Ends, int NumEnds) const;
+};
+
+// One-dimensional depth buffer of the walls around a player, binned by
+// angle around the center of the player's peeks on the XY plane. Keeps the
+// nearest wall along the ray through the center of each bin, which together
+// form a discrete visibility polygon. Walls in an enemy's bins are candidates
+// that must be confirmed with Wall::Blocks.
+class WallSweep
+{
+    float Depths[SWEEP_BINS];
+    int IDs[SWEEP_BINS];
+    FVector2D Origin;
+
+    // Gets the bins spanned by the directions to points.
+    // Bins may fall outside of the buffer and wrap around.
+    void GetBins(const FVector2D* Points, int Count, int& Bin0, int& Bin1) const;
+
+public:
+    // Empties the buffer and centers it on a new origin.
+    void Clear(const FVector2D& NewOrigin);
+    // Inserts a wall, keeping the nearest wall in each bin.
+    void Insert(const Wall& W, int ID);
+    // Appends the distinct IDs of walls in the bins spanned by points.
+    void GetCandidates(const FVector2D* Points, int Count, std::vector<int>& Candidates) const;
+};